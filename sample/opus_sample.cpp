@@ -10,174 +10,825 @@
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include "../src/opus_frame_parser.h"
+#include "../src/opus_frame_header.h"
+#include "../src/opus_packet_writer.h"
+#include "../src/opus_ogg_muxer.h"
+#include "../src/opus_spsc_queue.h"
+#include "../src/opus_packet_filter.h"
+#include "../src/opus_packet_sync.h"
+#include "../src/opus_stream_analyzer.h"
+#include "../src/opus_analysis_cache.h"
+#include "../src/opus_stream_sampler.h"
+#include "../src/opus_fingerprint.h"
+#include "../src/opus_daemon.h"
+#include "../src/opus_trace.h"
+#include "../src/opus_utils.h"
 #include "../src/opus_types.h"
 
 using namespace opus_analyzer;
 
+// 打印单帧头部符号
+void printFrameHeader(std::ostream& os, const OpusFrameHeaderInfo& header) {
+    if (!header.decoded) {
+        os << " (无头部符号)";
+        return;
+    }
+    if (header.has_silk) {
+        for (int ch = 0; ch < header.silk_channels; ch++) {
+            os << (ch == 0 ? " | VAD: " : " / ");
+            for (int i = 0; i < header.silk_frame_count; i++) {
+                os << (header.vad_flags[ch][i] ? 1 : 0);
+            }
+            os << " LBRR: ";
+            for (int i = 0; i < header.silk_frame_count; i++) {
+                os << (header.lbrr_flags[ch][i] ? 1 : 0);
+            }
+        }
+    }
+    if (header.has_celt) {
+        os << " | 静音: " << (header.celt_silence ? "是" : "否");
+        os << " 后置滤波: " << (header.celt_post_filter ? "是" : "否");
+        if (header.celt_post_filter) {
+            os << " (基音 " << header.post_filter_pitch
+                      << ", 增益 " << (int)header.post_filter_gain
+                      << ", 抽头 " << (int)header.post_filter_tapset << ")";
+        }
+        os << " 瞬态: " << (header.celt_transient ? "是" : "否");
+    }
+}
+
 // 打印 Opus 帧信息
-void printOpusFrameInfo(const OpusFrameInfo& frame_info, int frame_index) {
-    std::cout << "\n========== Opus 包 #" << frame_index << " ==========" << std::endl;
-    std::cout << "TOC 字节: 0x" << std::hex << std::setw(2) << std::setfill('0') 
+void printOpusFrameInfo(std::ostream& os, const OpusFrameInfo& frame_info,
+                        const std::vector<OpusFrameHeaderInfo>& headers, uint64_t frame_index, uint64_t offset) {
+    os << "\n========== Opus 包 #" << frame_index << " ==========" << std::endl;
+    os << "文件偏移: " << offset << std::endl;
+    os << "TOC 字节: 0x" << std::hex << std::setw(2) << std::setfill('0') 
               << (int)frame_info.toc_byte << std::dec << std::endl;
-    std::cout << "配置数 (config): " << (int)frame_info.config << std::endl;
-    std::cout << "编码模式: " << getModeString(frame_info.mode) << std::endl;
-    std::cout << "音频带宽: " << getBandwidthString(frame_info.bandwidth) << std::endl;
-    std::cout << "帧长度: " << getFrameSizeString(frame_info.frame_size) << std::endl;
-    std::cout << "立体声: " << (frame_info.stereo ? "是" : "否") << std::endl;
-    std::cout << "帧数代码 (c): " << (int)frame_info.frame_count_code << std::endl;
-    std::cout << "实际帧数: " << frame_info.frame_count << std::endl;
-    std::cout << "包总大小: " << frame_info.total_size << " 字节" << std::endl;
-    std::cout << "数据起始偏移: " << frame_info.data_offset << " 字节" << std::endl;
-    std::cout << "带分界包: " << (frame_info.is_self_delimiting ? "是" : "否") << std::endl;
+    os << "配置数 (config): " << (int)frame_info.config << std::endl;
+    os << "编码模式: " << getModeString(frame_info.mode) << std::endl;
+    os << "音频带宽: " << getBandwidthString(frame_info.bandwidth) << std::endl;
+    os << "帧长度: " << getFrameSizeString(frame_info.frame_size) << std::endl;
+    os << "立体声: " << (frame_info.stereo ? "是" : "否") << std::endl;
+    os << "帧数代码 (c): " << (int)frame_info.frame_count_code << std::endl;
+    os << "实际帧数: " << frame_info.frame_count << std::endl;
+    os << "包总大小: " << frame_info.total_size << " 字节" << std::endl;
+    os << "数据起始偏移: " << frame_info.data_offset << " 字节" << std::endl;
+    os << "带分界包: " << (frame_info.is_self_delimiting ? "是" : "否") << std::endl;
 
     if (frame_info.frame_count_code == 3) {
-        std::cout << "CBR/VBR: " << (frame_info.is_cbr ? "CBR" : "VBR") << std::endl;
-        std::cout << "有填充字节: " << (frame_info.has_padding ? "是" : "否") << std::endl;
+        os << "CBR/VBR: " << (frame_info.is_cbr ? "CBR" : "VBR") << std::endl;
+        os << "有填充字节: " << (frame_info.has_padding ? "是" : "否") << std::endl;
         if (frame_info.has_padding) {
-            std::cout << "填充字节数: " << frame_info.padding_size << " 字节" << std::endl;
+            os << "填充字节数: " << frame_info.padding_size << " 字节" << std::endl;
         }
     }
 
     if (!frame_info.frame_sizes.empty()) {
-        std::cout << "\n各帧大小:" << std::endl;
+        os << "\n各帧大小:" << std::endl;
         for (size_t i = 0; i < frame_info.frame_sizes.size(); i++) {
-            std::cout << "  帧 #" << (i + 1) << ": " << frame_info.frame_sizes[i] << " 字节" << std::endl;
+            os << "  帧 #" << (i + 1) << ": " << frame_info.frame_sizes[i] << " 字节";
+            if (i < headers.size()) {
+                printFrameHeader(os, headers[i]);
+            }
+            os << std::endl;
         }
     }
-    std::cout << "=====================================" << std::endl;
+    os << "=====================================" << std::endl;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "用法: " << argv[0] << " <opus_file>" << std::endl;
-        std::cerr << "示例: " << argv[0] << " ../../test.opus" << std::endl;
-        return 1;
+// 输出格式
+enum class OutputFormat {
+    RAW,            // 普通包首尾相接
+    SELF_DELIMITING, // 带分界包
+    OGG             // Ogg Opus
+};
+
+// 重组包输出状态
+struct OutputState {
+    int fd;
+    OutputFormat format;
+    int merge;                    // 每个输出包合并的输入包数
+    int pending;                  // 已加入重组包器的输入包数
+    OpusRepacketizer repacketizer;
+    std::unique_ptr<OggOpusMuxer> muxer;
+};
+
+// 输出重组包器中已收集的帧（去除填充字节）
+bool flushOutput(OutputState& out) {
+    if (out.repacketizer.frameCount() == 0) {
+        return true;
+    }
+    OPUS_TRACE_SCOPE("flush output");
+    OpusPacketOptions options;
+    options.self_delimiting = out.format == OutputFormat::SELF_DELIMITING;
+    options.padding_size = 0;
+    OpusPacketBuffer packet;
+    bool ok = out.repacketizer.buildPacket(options, packet);
+    if (ok) {
+        if (out.muxer != nullptr) {
+            ok = out.muxer->writePacket(packet, out.repacketizer.sampleCount());
+        } else {
+            ok = writeOpusPacket(out.fd, packet);
+        }
     }
+    out.repacketizer.reset();
+    out.pending = 0;
+    return ok;
+}
 
-    const char* opus_file = argv[1];
-    FILE* infile = fopen(opus_file, "rb");
-    if (infile == nullptr) {
-        std::cerr << "错误: 无法打开文件: " << opus_file << std::endl;
-        return 1;
+// 将一个解析出的包加入输出
+bool outputPacket(OutputState& out, const uint8_t* data, size_t length, const OpusFrameInfo& frame_info) {
+    if (out.format == OutputFormat::OGG && out.muxer == nullptr) {
+        // 声道数取第一个包的立体声标志
+        OggOpusConfig config;
+        memset(&config, 0, sizeof(config));
+        config.serial = 0x4f505553;
+        config.channels = frame_info.stereo ? 2 : 1;
+        config.pre_skip = OGG_OPUS_DEFAULT_PRE_SKIP;
+        config.input_sample_rate = 48000;
+        out.muxer.reset(new OggOpusMuxer(out.fd, config));
+        if (!out.muxer->writeHeaders()) {
+            return false;
+        }
     }
+    if (!out.repacketizer.addPacket(data, length, frame_info)) {
+        // 配置变化或超过 120 ms：先输出已收集的帧
+        if (!flushOutput(out) || !out.repacketizer.addPacket(data, length, frame_info)) {
+            return false;
+        }
+    }
+    out.pending++;
+    if (out.pending >= out.merge) {
+        return flushOutput(out);
+    }
+    return true;
+}
 
-    std::cout << "正在解析 Opus 文件: " << opus_file << std::endl;
-    std::cout << "解析每一帧的配置信息..." << std::endl;
+// 流水线参数
+const size_t kChunkSize = 1024 * 1024;      // 每次读取的字节数
+const size_t kCarrySize = 128 * 1024;       // 块首预留区：容纳上一块未解析的尾部
+const size_t kChunkCount = 4;               // 读取缓冲区个数
+const size_t kBatchSize = 256;              // 每批包数
 
-    // 分配缓冲区
-    const size_t BUFSIZE = 32 * 1024 * 1024; // 32MB
-    uint8_t* buf = (uint8_t*)malloc(BUFSIZE);
-    if (buf == nullptr) {
-        std::cerr << "错误: 无法分配内存" << std::endl;
-        fclose(infile);
-        return 1;
-    }
+// 读取块：数据位于 [begin, end)，块首预留 kCarrySize 字节
+struct Chunk {
+    uint8_t* data;
+    size_t begin;
+    size_t end;
+    uint64_t base;                // data[begin] 在文件中的绝对偏移
+};
+
+// 已解析的包
+struct ParsedPacket {
+    uint64_t index;
+    uint64_t offset;              // 包在文件中的绝对偏移
+    OpusFrameInfo frame_info;
+    std::vector<OpusFrameHeaderInfo> headers;
+    const uint8_t* data;          // 包数据（批次提交前有效）
+    size_t length;                // 可用数据长度
+};
+
+// 一批已解析的包
+struct PacketBatch {
+    OpusPacketColumns columns;    // 过滤用的列
+    std::vector<ParsedPacket> packets;
+};
 
-    size_t rsz = 0;
-    size_t sz = 0;
-    uint8_t* p = buf;
-    int packet_count = 0;
-    size_t current_offset = 0;
+// 各阶段之间的队列，传递的都是句柄
+struct Pipeline {
+    SpscQueue<Chunk*> free_chunks;          // 解析 -> 读取：归还的缓冲区
+    SpscQueue<Chunk*> full_chunks;          // 读取 -> 解析
+    SpscQueue<PacketBatch*> batches;        // 解析 -> 格式化
+    SpscQueue<std::string*> texts;          // 格式化 -> 写出
+    const OpusPacketFilter* filter;        // 为 nullptr 时不过滤
+    OpusPacketSync sync;                    // 包边界同步状态（只由解析线程使用）
+    uint64_t packet_count;
+    uint64_t matched_count;
 
-    // 读取并解析 Opus 流
+    Pipeline() : free_chunks(kChunkCount * 2), full_chunks(kChunkCount * 2),
+                 batches(16), texts(16), filter(nullptr), packet_count(0), matched_count(0) {}
+};
+
+// 读取阶段：填充空闲缓冲区，读到文件末尾时发送 nullptr
+void readerStage(Pipeline& pipeline, FILE* infile) {
+    OPUS_TRACE_THREAD("reader");
+    uint64_t file_offset = 0;
     while (1) {
-        rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
+        Chunk* chunk = pipeline.free_chunks.pop();
+        size_t rsz;
+        {
+            OPUS_TRACE_SCOPE("read");
+            rsz = fread(chunk->data + kCarrySize, 1, kChunkSize, infile);
+        }
         if (rsz == 0) {
             if (ferror(infile)) {
                 std::cerr << "错误: 读取文件失败" << std::endl;
-                break;
             }
             break; // EOF
         }
+        chunk->begin = kCarrySize;
+        chunk->end = kCarrySize + rsz;
+        chunk->base = file_offset;
+        file_offset += rsz;
+        pipeline.full_chunks.push(chunk);
+    }
+    pipeline.full_chunks.push(nullptr);
+}
 
-        sz += rsz;
-
-        // 尝试解析 Opus 包
-        // Opus 裸流：第一个字节就是 TOC，按照协议规范解析
-        while (current_offset < sz) {
-            OpusFrameInfo frame_info;
-            if (parseOpusPacket(p + current_offset, sz - current_offset, frame_info)) {
-                packet_count++;
-                printOpusFrameInfo(frame_info, packet_count);
-
-                // 移动到下一个包
-                if (frame_info.total_size > 0) {
-                    current_offset += frame_info.total_size;
-                } else {
-                    // 如果无法确定包大小（例如 3 号包），尝试查找下一个有效的包
-                    // 对于 Opus 裸流，我们只能通过尝试解析来确定包边界
-                    // 从当前包的数据结束位置开始查找
-                    size_t data_end = current_offset + frame_info.data_offset + 
-                                     (frame_info.frame_sizes.empty() ? 0 : 
-                                      frame_info.frame_sizes[0] * frame_info.frame_count);
-                    size_t next_offset = data_end;
-                    bool found_next = false;
-                    // 尝试从数据结束位置开始解析，最多尝试 1000 个字节
-                    for (size_t i = 0; i < 1000 && next_offset < sz; i++) {
-                        OpusFrameInfo test_info;
-                        if (parseOpusPacket(p + next_offset, sz - next_offset, test_info)) {
-                            // 找到了下一个有效的包
-                            current_offset = next_offset;
-                            found_next = true;
-                            break;
-                        }
-                        next_offset++;
-                    }
-                    if (!found_next) {
-                        // 没有找到下一个包，向前移动一个字节
-                        current_offset++;
-                    }
+// 提交一批包：先按过滤条件筛选，再对选中的包解码帧头部并输出
+// 必须在包所在的缓冲区归还之前调用
+void submitBatch(Pipeline& pipeline, OutputState& out, PacketBatch*& batch) {
+    if (batch->packets.empty()) {
+        return;
+    }
+    OPUS_TRACE_SCOPE("submit batch");
+    std::vector<ParsedPacket>& packets = batch->packets;
+    if (pipeline.filter != nullptr) {
+        std::vector<uint8_t> selected;
+        filterPackets(*pipeline.filter, batch->columns, selected);
+        size_t kept = 0;
+        for (size_t i = 0; i < packets.size(); i++) {
+            if (selected[i]) {
+                if (kept != i) {
+                    packets[kept] = packets[i];
                 }
+                kept++;
+            }
+        }
+        packets.resize(kept);
+    }
+    batch->columns.clear();
+
+    for (size_t i = 0; i < packets.size(); i++) {
+        ParsedPacket& packet = packets[i];
+        parseFrameHeaders(packet.data, packet.length, packet.frame_info, packet.headers);
+        uint32_t packet_size = getPacketSize(packet.frame_info);
+        if (out.fd >= 0 && packet_size > 0 &&
+            !outputPacket(out, packet.data, packet_size, packet.frame_info)) {
+            std::cerr << "错误: 写入输出文件失败" << std::endl;
+        }
+        packet.data = nullptr;
+    }
+    pipeline.matched_count += packets.size();
+
+    if (packets.empty()) {
+        return;
+    }
+    pipeline.batches.push(batch);
+    batch = new PacketBatch();
+}
+
+// 解析块内 [current_offset, limit) 起始的包，可用数据到块尾为止，返回停止位置
+size_t parseWindow(Pipeline& pipeline, OutputState& out, PacketBatch*& batch,
+                   const Chunk& chunk, size_t current_offset, size_t limit) {
+    OPUS_TRACE_SCOPE("parse");
+    const uint8_t* p = chunk.data;
+    size_t end = chunk.end;
+    // Opus 裸流：第一个字节就是 TOC，按照协议规范解析
+    while (current_offset < limit) {
+        // 只接受打分确认的包边界；失去同步时跳到下一个得分足够的位置，跳过的字节按区间记录
+        OpusFrameInfo frame_info;
+        size_t next = 0;
+        uint32_t packet_size = pipeline.sync.parse(p + chunk.begin, end - chunk.begin, current_offset - chunk.begin,
+                                                   limit - chunk.begin, chunk.base, frame_info, next);
+        if (packet_size == 0) {
+            current_offset = chunk.begin + next;
+            continue;
+        }
+
+        ParsedPacket packet;
+        packet.index = ++pipeline.packet_count;
+        packet.offset = chunk.base + (current_offset - chunk.begin);
+        packet.frame_info = frame_info;
+        packet.data = p + current_offset;
+        packet.length = end - current_offset;
+        batch->packets.push_back(packet);
+        batch->columns.append(frame_info);
+        if (batch->packets.size() >= kBatchSize) {
+            submitBatch(pipeline, out, batch);
+        }
+
+        // 移动到下一个包
+        current_offset += packet_size;
+    }
+    return current_offset < end ? current_offset : end;
+}
+
+// 解析阶段：每块只解析起始于块尾 kCarrySize 之前的包，
+// 剩余尾部复制到下一块的预留区，使跨块的包能完整解析
+void parseStage(Pipeline& pipeline, OutputState& out) {
+    OPUS_TRACE_THREAD("parser");
+    PacketBatch* batch = new PacketBatch();
+    Chunk* prev = nullptr;
+    size_t prev_offset = 0;
+
+    while (1) {
+        Chunk* chunk = pipeline.full_chunks.pop();
+        if (prev != nullptr) {
+            if (chunk == nullptr) {
+                // 最后一块：解析到数据末尾
+                parseWindow(pipeline, out, batch, *prev, prev_offset, prev->end);
             } else {
-                // 解析失败，可能是数据不完整或不是有效的 Opus 包
-                // 尝试向前移动一个字节继续查找
-                current_offset++;
-                
-                // 如果已经移动到缓冲区末尾，需要读取更多数据
-                if (current_offset >= sz) {
-                    break;
-                }
+                size_t tail = prev->end - prev_offset;
+                memcpy(chunk->data + kCarrySize - tail, prev->data + prev_offset, tail);
+                chunk->begin = kCarrySize - tail;
+                chunk->base -= tail;
             }
+            // 批次和重组包器引用缓冲区中的数据：归还缓冲区前先提交批次，
+            // 重组包器中未凑满的帧复制出来，合并分组不受块边界影响
+            submitBatch(pipeline, out, batch);
+            out.repacketizer.retainFrames();
+            pipeline.free_chunks.push(prev);
+            prev = nullptr;
+        }
+        if (chunk == nullptr) {
+            break;
+        }
+
+        size_t window = chunk->end - chunk->begin;
+        size_t limit = window > kCarrySize ? chunk->end - kCarrySize : chunk->begin;
+        prev_offset = parseWindow(pipeline, out, batch, *chunk, chunk->begin, limit);
+        prev = chunk;
+    }
+
+    // 文件末尾：输出最后一组
+    if (out.fd >= 0 && !flushOutput(out)) {
+        std::cerr << "错误: 写入输出文件失败" << std::endl;
+    }
+    if (!batch->packets.empty()) {
+        pipeline.batches.push(batch);
+    } else {
+        delete batch;
+    }
+    pipeline.batches.push(nullptr);
+}
+
+// 格式化阶段：把一批包格式化为文本
+void formatStage(Pipeline& pipeline) {
+    OPUS_TRACE_THREAD("formatter");
+    while (1) {
+        PacketBatch* batch = pipeline.batches.pop();
+        if (batch == nullptr) {
+            break;
+        }
+        OPUS_TRACE_SCOPE("format batch");
+        std::ostringstream os;
+        for (size_t i = 0; i < batch->packets.size(); i++) {
+            const ParsedPacket& packet = batch->packets[i];
+            printOpusFrameInfo(os, packet.frame_info, packet.headers, packet.index, packet.offset);
+        }
+        delete batch;
+        pipeline.texts.push(new std::string(os.str()));
+    }
+    pipeline.texts.push(nullptr);
+}
+
+// 写出阶段：写到标准输出
+void writerStage(Pipeline& pipeline) {
+    OPUS_TRACE_THREAD("writer");
+    while (1) {
+        std::string* text = pipeline.texts.pop();
+        if (text == nullptr) {
+            break;
+        }
+        OPUS_TRACE_SCOPE("write");
+        fwrite(text->data(), 1, text->size(), stdout);
+        delete text;
+    }
+    fflush(stdout);
+}
+
+// 打印跳过的字节区间
+void printSkippedRanges(const std::vector<OpusByteRange>& ranges, uint64_t range_count) {
+    for (size_t i = 0; i < ranges.size(); i++) {
+        const OpusByteRange& range = ranges[i];
+        std::cout << "  [" << range.offset << ", " << range.offset + range.length << ") "
+                  << range.length << " 字节" << std::endl;
+    }
+    if (range_count > ranges.size()) {
+        std::cout << "  ... 另有 " << range_count - ranges.size() << " 个区间未列出" << std::endl;
+    }
+}
 
-            // 防止无限循环
-            if (current_offset >= sz) {
-                break;
+// 打印文件摘要
+void printFileSummary(const OpusFileAnalysis& analysis, const std::vector<OpusByteRange>& skipped_ranges) {
+    const OpusStreamSummary& summary = analysis.summary;
+    double duration = summary.total_samples / 48000.0;
+    std::cout << "\n========== 文件摘要 ==========" << std::endl;
+    std::cout << "包数: " << summary.packet_count << std::endl;
+    std::cout << "帧数: " << summary.frame_count << std::endl;
+    std::cout << "总字节数: " << summary.total_bytes << " 字节" << std::endl;
+    std::cout << "时长: " << std::fixed << std::setprecision(3) << duration << " 秒" << std::endl;
+    if (duration > 0) {
+        std::cout << "平均码率: " << std::setprecision(1) << summary.total_bytes * 8 / duration / 1000
+                  << " kbps" << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << "包大小: " << summary.min_packet_size << " - " << summary.max_packet_size << " 字节" << std::endl;
+    std::cout << "立体声包数: " << summary.stereo_count << std::endl;
+    std::cout << "跳过字节数: " << summary.skipped_bytes << std::endl;
+    printSkippedRanges(skipped_ranges, skipped_ranges.size());
+    for (int code = 0; code < 4; code++) {
+        std::cout << code << "号包: " << summary.code_counts[code] << std::endl;
+    }
+    std::cout << "\n各配置包数:" << std::endl;
+    for (int config = 0; config < 32; config++) {
+        if (summary.config_counts[config] == 0) {
+            continue;
+        }
+        OpusMode mode;
+        OpusBandwidth bandwidth;
+        OpusFrameSize frame_size;
+        getConfigInfo(config, mode, bandwidth, frame_size);
+        std::cout << "  config " << config << " (" << getModeString(mode) << ", " << getBandwidthString(bandwidth)
+                  << ", " << getFrameSizeString(frame_size) << "): " << summary.config_counts[config] << std::endl;
+    }
+    std::cout << "定位点数: " << analysis.index.size() << std::endl;
+}
+
+// 打印抽样估计结果
+void printSampleResult(const OpusSampleResult& result) {
+    std::cout << "\n========== 抽样估计 ==========" << std::endl;
+    std::cout << "文件大小: " << result.file_size << " 字节" << std::endl;
+    std::cout << "读取字节数: " << result.bytes_read << " 字节 (" << std::fixed << std::setprecision(2)
+              << (result.file_size > 0 ? 100.0 * result.bytes_read / result.file_size : 0) << "%)" << std::endl;
+    std::cout << "有效窗口数: " << result.windows << (result.exact ? "（完整分析）" : "") << std::endl;
+    std::cout << std::setprecision(0);
+    std::cout << "包数: " << result.packets.value << " ± " << result.packets.error << std::endl;
+    std::cout << std::setprecision(1);
+    std::cout << "时长: " << result.duration.value << " ± " << result.duration.error << " 秒" << std::endl;
+    std::cout << "平均码率: " << result.bitrate.value / 1000 << " ± " << result.bitrate.error / 1000
+              << " kbps" << std::endl;
+    std::cout << "\n各配置包数占比:" << std::endl;
+    for (int config = 0; config < 32; config++) {
+        if (result.sampled.config_counts[config] == 0) {
+            continue;
+        }
+        std::cout << "  config " << config << ": " << result.config_share[config].value * 100
+                  << "% ± " << result.config_share[config].error * 100 << "%" << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << "（误差为 95% 置信区间半宽）" << std::endl;
+}
+
+// 查找多个文件之间及文件内部重复的包序列
+int findDuplicates(const std::vector<const char*>& files, uint32_t kgram) {
+    OpusFingerprintIndex index(kgram, 16);
+    for (size_t i = 0; i < files.size(); i++) {
+        OpusFileAnalysis analysis;
+        resetFileAnalysis(analysis);
+        std::vector<uint64_t> fingerprints;
+        if (!analyzeOpusFile(files[i], analysis, &fingerprints)) {
+            std::cerr << "错误: 无法分析文件: " << files[i] << std::endl;
+            return 1;
+        }
+        index.addFile(files[i], fingerprints);
+        std::cout << files[i] << ": " << fingerprints.size() << " 个包" << std::endl;
+    }
+
+    const std::vector<OpusSharedRun>& runs = index.runs();
+    std::cout << "\n========== 重复片段 ==========" << std::endl;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const OpusSharedRun& run = runs[i];
+        std::cout << index.fileName(run.file_a) << " 包 #" << run.packet_a + 1 << " - #" << run.packet_a + run.length
+                  << " 与 " << index.fileName(run.file_b) << " 包 #" << run.packet_b + 1 << " - #"
+                  << run.packet_b + run.length << " 相同（" << run.length << " 个包）" << std::endl;
+    }
+    std::cout << "共 " << runs.size() << " 个重复片段" << std::endl;
+    return 0;
+}
+
+// 跟踪结果输出文件，进程退出时导出
+const char* g_trace_file = nullptr;
+
+void exportTrace() {
+    if (!OPUS_TRACE_EXPORT(g_trace_file)) {
+        std::cerr << "错误: 无法写入跟踪文件: " << g_trace_file << std::endl;
+    }
+}
+
+// 以常驻服务方式运行，收到 SIGINT/SIGTERM 时退出
+int runDaemon(const OpusDaemonConfig& config) {
+    // 信号由专门的线程处理，其他线程屏蔽这两个信号
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    OpusAnalyzerDaemon daemon(config);
+    if (!daemon.start()) {
+        std::cerr << "错误: 无法监听套接字: " << config.socket_path << std::endl;
+        return 1;
+    }
+    std::thread signal_thread([&daemon, &signals]() {
+        int sig = 0;
+        sigwait(&signals, &sig);
+        daemon.stop();
+    });
+    std::cout << "服务已启动: " << config.socket_path << "（" << config.worker_count << " 个工作线程）" << std::endl;
+    daemon.run();
+    // run 因其他原因退出时，唤醒信号线程
+    kill(getpid(), SIGTERM);
+    signal_thread.join();
+    return 0;
+}
+
+// 向常驻服务查询文件摘要，或指定时间（秒）对应的定位点
+int queryDaemon(const char* socket_path, const char* file, double seek_time) {
+    char resolved[PATH_MAX];
+    if (realpath(file, resolved) == nullptr) {
+        std::cerr << "错误: 无法打开文件: " << file << std::endl;
+        return 1;
+    }
+    uint8_t type = seek_time >= 0 ? OPUS_DAEMON_SEEK : OPUS_DAEMON_ANALYZE;
+    uint64_t arg = seek_time >= 0 ? static_cast<uint64_t>(seek_time * 48000) : 0;
+    uint8_t status = OPUS_DAEMON_ERROR;
+    std::vector<uint8_t> response;
+    if (!opusDaemonRequest(socket_path, type, resolved, arg, status, response)) {
+        std::cerr << "错误: 无法连接服务: " << socket_path << std::endl;
+        return 1;
+    }
+    if (status != OPUS_DAEMON_OK) {
+        std::cerr << "错误: 服务无法分析文件: " << resolved << std::endl;
+        return 1;
+    }
+
+    if (type == OPUS_DAEMON_SEEK) {
+        uint64_t fields[3] = {0, 0, 0};
+        for (size_t i = 0; i < 3 * 8 && i < response.size(); i++) {
+            fields[i / 8] |= static_cast<uint64_t>(response[i]) << (8 * (i % 8));
+        }
+        std::cout << "定位点: 偏移 " << fields[0] << "，采样位置 " << fields[1] << " ("
+                  << std::fixed << std::setprecision(3) << fields[1] / 48000.0 << " 秒)，包 #"
+                  << fields[2] + 1 << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        return 0;
+    }
+    OpusFileAnalysis analysis;
+    size_t bytes_read = 0;
+    if (!deserializeFileAnalysis(response.data(), response.size(), analysis, bytes_read)) {
+        std::cerr << "错误: 无效的响应" << std::endl;
+        return 1;
+    }
+    printFileSummary(analysis, std::vector<OpusByteRange>());
+    return 0;
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "用法: " << prog << " [选项] <opus_file>" << std::endl;
+    std::cerr << "选项:" << std::endl;
+    std::cerr << "  -o <file>               将解析出的包重新组包写入文件（去除填充字节）" << std::endl;
+    std::cerr << "  --format <raw|sd|ogg>   输出格式：普通包、带分界包或 Ogg Opus（默认 raw）" << std::endl;
+    std::cerr << "  --merge <n>             将连续 n 个包的帧合并为一个 3 号包（最多 120 ms）" << std::endl;
+    std::cerr << "  --filter <expr>         只输出满足条件的包，条件以逗号分隔，例如：" << std::endl;
+    std::cerr << "                          mode=celt,bw=fb,stereo,size>200    code=3,padding" << std::endl;
+    std::cerr << "                          条件：mode= bw= fs= config= code= stereo mono padding sd cbr vbr size frames" << std::endl;
+    std::cerr << "  --summary               只输出文件摘要（包数、时长、码率、配置分布）" << std::endl;
+    std::cerr << "  --cache <dir>           输出摘要，并将分析结果缓存到目录（未变化的文件直接读取缓存）" << std::endl;
+    std::cerr << "  --hash                  缓存时额外比较文件首尾内容的哈希（被追加的文件从检查点继续分析）" << std::endl;
+    std::cerr << "  --sample <fraction>     抽样估计：只读取文件的一部分（例如 0.01），推算包数、时长、码率和配置分布" << std::endl;
+    std::cerr << "  --windows <k>           抽样窗口数（默认 64）" << std::endl;
+    std::cerr << "  --random                抽样窗口在各段内随机取位置（默认等间隔）" << std::endl;
+    std::cerr << "  --seed <n>              随机抽样的种子" << std::endl;
+    std::cerr << "  --dups <file>...        按包指纹查找多个文件之间及文件内部重复的包序列" << std::endl;
+    std::cerr << "  --kgram <n>             重复片段的最短包数（默认 8）" << std::endl;
+    std::cerr << "  --daemon <socket>       以常驻服务方式运行，在 Unix 套接字上接收分析请求" << std::endl;
+    std::cerr << "  --workers <n>           服务的工作线程数（默认 CPU 数）" << std::endl;
+    std::cerr << "  --connect <socket>      通过常驻服务获取文件摘要" << std::endl;
+    std::cerr << "  --seek <seconds>        通过常驻服务查询指定时间之前最近的定位点（与 --connect 一起使用）" << std::endl;
+    std::cerr << "  --trace <file>          退出时将各阶段耗时导出为 Chrome trace JSON（需以 OPUS_ANALYZER_TRACE=ON 编译）" << std::endl;
+    std::cerr << "示例: " << prog << " ../../test.opus" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const char* opus_file = nullptr;
+    const char* output_file = nullptr;
+    OutputState out;
+    out.fd = -1;
+    out.format = OutputFormat::RAW;
+    out.merge = 1;
+    out.pending = 0;
+    OpusPacketFilter filter;
+    bool use_filter = false;
+    bool summary_only = false;
+    const char* cache_dir = nullptr;
+    bool use_hash = false;
+    bool sample_mode = false;
+    bool dups_mode = false;
+    uint32_t kgram = 8;
+    const char* daemon_socket = nullptr;
+    const char* connect_socket = nullptr;
+    double seek_time = -1;
+    OpusDaemonConfig daemon_config;
+    getDefaultDaemonConfig(daemon_config);
+    std::vector<const char*> input_files;
+    OpusSampleOptions sample_options;
+    getDefaultSampleOptions(sample_options);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* format = argv[++i];
+            if (strcmp(format, "raw") == 0) {
+                out.format = OutputFormat::RAW;
+            } else if (strcmp(format, "sd") == 0) {
+                out.format = OutputFormat::SELF_DELIMITING;
+            } else if (strcmp(format, "ogg") == 0) {
+                out.format = OutputFormat::OGG;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--merge") == 0 && i + 1 < argc) {
+            out.merge = atoi(argv[++i]);
+            if (out.merge < 1) {
+                out.merge = 1;
             }
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            if (!compilePacketFilter(argv[++i], filter)) {
+                std::cerr << "错误: 无效的过滤条件: " << argv[i] << std::endl;
+                return 1;
+            }
+            use_filter = true;
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary_only = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+            summary_only = true;
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            use_hash = true;
+        } else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+            sample_options.fraction = atof(argv[++i]);
+            sample_mode = true;
+        } else if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+            sample_options.window_count = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--random") == 0) {
+            sample_options.random = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            sample_options.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--dups") == 0) {
+            dups_mode = true;
+        } else if (strcmp(argv[i], "--kgram") == 0 && i + 1 < argc) {
+            kgram = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--daemon") == 0 && i + 1 < argc) {
+            daemon_socket = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            daemon_config.worker_count = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            connect_socket = argv[++i];
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seek_time = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            g_trace_file = argv[++i];
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input_files.push_back(argv[i]);
+        }
+    }
+    if (g_trace_file != nullptr) {
+        if (!OPUS_ANALYZER_TRACE) {
+            std::cerr << "警告: 未启用跟踪，请以 -DOPUS_ANALYZER_TRACE=ON 重新编译" << std::endl;
+        } else {
+            OPUS_TRACE_THREAD("main");
+            atexit(exportTrace);
+        }
+    }
+    if (daemon_socket != nullptr) {
+        daemon_config.socket_path = daemon_socket;
+        return runDaemon(daemon_config);
+    }
+    if (input_files.empty() || (input_files.size() > 1 && !dups_mode)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    opus_file = input_files[0];
+
+    if (dups_mode) {
+        return findDuplicates(input_files, kgram);
+    }
+
+    if (connect_socket != nullptr) {
+        return queryDaemon(connect_socket, opus_file, seek_time);
+    }
+
+    if (sample_mode) {
+        OpusSampleResult result;
+        if (!sampleOpusFile(opus_file, sample_options, result)) {
+            std::cerr << "错误: 无法分析文件: " << opus_file << std::endl;
+            return 1;
         }
+        printSampleResult(result);
+        return 0;
+    }
 
-        // 保留未处理的数据到缓冲区开头
-        if (current_offset > 0 && current_offset < sz) {
-            size_t remaining = sz - current_offset;
-            memmove(buf, p + current_offset, remaining);
-            sz = remaining;
-            current_offset = 0;
-        } else if (current_offset >= sz) {
-            // 所有数据都已处理
-            sz = 0;
-            current_offset = 0;
-        }
-
-        // 如果缓冲区已满但没有找到有效包，可能需要清空部分数据
-        if (sz >= BUFSIZE - 1024) {
-            // 保留最后 4KB 数据，以防包跨越边界
-            size_t keep_size = 4096;
-            if (sz > keep_size) {
-                memmove(buf, p + sz - keep_size, keep_size);
-                sz = keep_size;
-                current_offset = 0;
+    if (summary_only) {
+        OpusFileAnalysis analysis;
+        resetFileAnalysis(analysis);
+        std::vector<OpusByteRange> skipped_ranges;
+        bool ok;
+        if (cache_dir != nullptr) {
+            OpusAnalysisCache cache(cache_dir, use_hash);
+            OpusCacheStatus status;
+            ok = cache.analyze(opus_file, analysis, &status);
+            if (ok) {
+                std::cout << "缓存: " << (status == OpusCacheStatus::HIT ? "命中" :
+                                          status == OpusCacheStatus::INCREMENTAL ? "增量分析" : "未命中")
+                          << std::endl;
             }
+        } else {
+            ok = analyzeOpusFile(opus_file, analysis, nullptr, &skipped_ranges);
+        }
+        if (!ok) {
+            std::cerr << "错误: 无法分析文件: " << opus_file << std::endl;
+            return 1;
         }
+        printFileSummary(analysis, skipped_ranges);
+        return 0;
     }
 
+    if (output_file != nullptr) {
+        out.fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out.fd < 0) {
+            std::cerr << "错误: 无法创建输出文件: " << output_file << std::endl;
+            return 1;
+        }
+    }
+
+    FILE* infile;
+    {
+        OPUS_TRACE_SCOPE("open");
+        infile = fopen(opus_file, "rb");
+    }
+    if (infile == nullptr) {
+        std::cerr << "错误: 无法打开文件: " << opus_file << std::endl;
+        return 1;
+    }
+
+    std::cout << "正在解析 Opus 文件: " << opus_file << std::endl;
+    std::cout << "解析每一帧的配置信息..." << std::endl;
+
+    // 分配读取缓冲区
+    std::vector<Chunk> chunks(kChunkCount);
+    std::vector<uint8_t> chunk_memory(kChunkCount * (kCarrySize + kChunkSize));
+    Pipeline pipeline;
+    pipeline.filter = use_filter ? &filter : nullptr;
+    for (size_t i = 0; i < kChunkCount; i++) {
+        chunks[i].data = &chunk_memory[i * (kCarrySize + kChunkSize)];
+        chunks[i].begin = kCarrySize;
+        chunks[i].end = kCarrySize;
+        pipeline.free_chunks.push(&chunks[i]);
+    }
+
+    // 读取 -> 解析 -> 格式化 -> 写出，各阶段独立线程
+    std::cout.flush();
+    std::thread reader(readerStage, std::ref(pipeline), infile);
+    std::thread parser(parseStage, std::ref(pipeline), std::ref(out));
+    std::thread formatter(formatStage, std::ref(pipeline));
+    std::thread writer(writerStage, std::ref(pipeline));
+    reader.join();
+    parser.join();
+    formatter.join();
+    writer.join();
+    uint64_t packet_count = pipeline.packet_count;
+    uint64_t matched_count = pipeline.matched_count;
+
     std::cout << "\n========== 解析完成 ==========" << std::endl;
     std::cout << "总共找到 " << packet_count << " 个 Opus 包" << std::endl;
+    if (use_filter) {
+        std::cout << "满足过滤条件 " << matched_count << " 个" << std::endl;
+    }
+    if (pipeline.sync.skippedBytes() > 0) {
+        std::cout << "跳过 " << pipeline.sync.skippedBytes() << " 字节，共 "
+                  << pipeline.sync.skippedRangeCount() << " 个区间:" << std::endl;
+        printSkippedRanges(pipeline.sync.skippedRanges(), pipeline.sync.skippedRangeCount());
+    }
 
     // 清理资源
-    free(buf);
+    bool output_ok = true;
+    if (out.fd >= 0) {
+        if (out.muxer != nullptr && !out.muxer->finish()) {
+            std::cerr << "错误: 写入输出文件失败" << std::endl;
+            output_ok = false;
+        }
+        out.muxer.reset();
+        close(out.fd);
+    }
     fclose(infile);
 
-    return 0;
+    return output_ok ? 0 : 1;
 }
 
@@ -0,0 +1,224 @@
+/*
+ * Opus Analysis Cache
+ * 分析结果缓存实现
+ */
+
+#include "opus_analysis_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+namespace {
+
+const char kEntryMagic[4] = {'O', 'P', 'A', 'C'};
+const uint8_t kEntryVersion = 1;
+const size_t kKeySize = 6 * 8;
+const size_t kHashRegion = 64 * 1024;   // 参与哈希的首尾区域大小
+
+// 64 位 FNV-1a，每次处理 8 字节，最后做一次混合
+uint64_t hashBytes(const uint8_t* data, size_t length) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+    }
+    for (; i < length; i++) {
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+bool hashRegion(int fd, uint64_t offset, size_t length, uint64_t& hash) {
+    std::vector<uint8_t> buf(length);
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(fd, &buf[done], length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    hash = hashBytes(buf.data(), length);
+    return true;
+}
+
+void putLE64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+uint64_t getLE64(const uint8_t* data) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return v;
+}
+
+} // namespace
+
+bool getFileKey(int fd, bool use_content_hash, uint64_t hash_end, OpusFileKey& key) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+    memset(&key, 0, sizeof(key));
+    key.device = static_cast<uint64_t>(st.st_dev);
+    key.inode = static_cast<uint64_t>(st.st_ino);
+    key.size = static_cast<uint64_t>(st.st_size);
+    key.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+
+    if (!use_content_hash) {
+        return true;
+    }
+    // 开头一段，以及 hash_end 之前的一段（检查追加时 hash_end 为缓存时的文件大小）
+    if (hash_end == 0 || hash_end > key.size) {
+        hash_end = key.size;
+    }
+    size_t head = hash_end < kHashRegion ? static_cast<size_t>(hash_end) : kHashRegion;
+    return hashRegion(fd, 0, head, key.head_hash) &&
+           hashRegion(fd, hash_end - head, head, key.tail_hash);
+}
+
+OpusAnalysisCache::OpusAnalysisCache(const std::string& dir, bool use_content_hash)
+    : dir_(dir), use_content_hash_(use_content_hash) {
+    mkdir(dir_.c_str(), 0755);
+}
+
+bool OpusAnalysisCache::getFileKey(const char* path, uint64_t hash_end, OpusFileKey& key) const {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = opus_analyzer::getFileKey(fd, use_content_hash_, hash_end, key);
+    close(fd);
+    return ok;
+}
+
+std::string OpusAnalysisCache::getEntryPath(const OpusFileKey& key) const {
+    char name[64];
+    snprintf(name, sizeof(name), "/%02x/%llx-%llx", static_cast<unsigned>(key.inode & 0xFF),
+             static_cast<unsigned long long>(key.device), static_cast<unsigned long long>(key.inode));
+    return dir_ + name;
+}
+
+bool OpusAnalysisCache::loadEntry(const OpusFileKey& key, OpusFileKey& cached_key, OpusFileAnalysis& analysis) const {
+    FILE* fp = fopen(getEntryPath(key).c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+
+    // 魔数、版本、文件身份、分析结果
+    if (data.size() < sizeof(kEntryMagic) + 1 + kKeySize ||
+        memcmp(data.data(), kEntryMagic, sizeof(kEntryMagic)) != 0 || data[4] != kEntryVersion) {
+        return false;
+    }
+    const uint8_t* p = data.data() + 5;
+    cached_key.device = getLE64(p);
+    cached_key.inode = getLE64(p + 8);
+    cached_key.size = getLE64(p + 16);
+    cached_key.mtime_ns = static_cast<int64_t>(getLE64(p + 24));
+    cached_key.head_hash = getLE64(p + 32);
+    cached_key.tail_hash = getLE64(p + 40);
+    if (cached_key.device != key.device || cached_key.inode != key.inode) {
+        return false;
+    }
+    size_t offset = 5 + kKeySize;
+    size_t bytes_read = 0;
+    return deserializeFileAnalysis(data.data() + offset, data.size() - offset, analysis, bytes_read);
+}
+
+bool OpusAnalysisCache::storeEntry(const OpusFileKey& key, const OpusFileAnalysis& analysis) const {
+    std::vector<uint8_t> data(kEntryMagic, kEntryMagic + sizeof(kEntryMagic));
+    data.push_back(kEntryVersion);
+    putLE64(data, key.device);
+    putLE64(data, key.inode);
+    putLE64(data, key.size);
+    putLE64(data, static_cast<uint64_t>(key.mtime_ns));
+    putLE64(data, key.head_hash);
+    putLE64(data, key.tail_hash);
+    serializeFileAnalysis(analysis, data);
+
+    std::string path = getEntryPath(key);
+    std::string shard = path.substr(0, path.rfind('/'));
+    mkdir(shard.c_str(), 0755);
+
+    // 先写临时文件再重命名
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp%d", static_cast<int>(getpid()));
+    std::string tmp = path + suffix;
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OpusAnalysisCache::analyze(const char* path, OpusFileAnalysis& analysis, OpusCacheStatus* status) {
+    OpusFileKey key;
+    if (!getFileKey(path, 0, key)) {
+        return false;
+    }
+
+    OpusCacheStatus result = OpusCacheStatus::MISS;
+    OpusFileKey cached_key;
+    if (loadEntry(key, cached_key, analysis)) {
+        if (cached_key.size == key.size && cached_key.mtime_ns == key.mtime_ns &&
+            cached_key.head_hash == key.head_hash && cached_key.tail_hash == key.tail_hash) {
+            result = OpusCacheStatus::HIT;
+        } else if (key.size > cached_key.size) {
+            // 文件变大：只有开启内容哈希、确认原有内容未变时才从检查点继续；
+            // 没有哈希时无法区分追加和重写（修改时间总会变化），重新分析
+            OpusFileKey old_key;
+            if (use_content_hash_ && getFileKey(path, cached_key.size, old_key) &&
+                old_key.head_hash == cached_key.head_hash && old_key.tail_hash == cached_key.tail_hash) {
+                result = OpusCacheStatus::INCREMENTAL;
+            }
+        }
+    }
+    if (status != nullptr) {
+        *status = result;
+    }
+    if (result == OpusCacheStatus::HIT) {
+        return true;
+    }
+
+    if (result == OpusCacheStatus::MISS) {
+        resetFileAnalysis(analysis);
+    }
+    if (!analyzeOpusFile(path, analysis)) {
+        return false;
+    }
+    storeEntry(key, analysis);
+    return true;
+}
+
+} // namespace opus_analyzer
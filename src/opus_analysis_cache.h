@@ -0,0 +1,74 @@
+/*
+ * Opus Analysis Cache
+ * 按文件身份缓存分析结果的磁盘缓存
+ */
+
+#pragma once
+
+#include "opus_stream_analyzer.h"
+#include <stdint.h>
+#include <string>
+
+namespace opus_analyzer {
+
+// 缓存查询结果
+enum class OpusCacheStatus {
+    HIT,          // 文件未变化，直接返回缓存结果
+    INCREMENTAL,  // 文件被追加，从检查点继续分析
+    MISS          // 无缓存或文件已变化，重新分析
+};
+
+// 文件身份：设备号、inode、大小、修改时间，以及可选的内容哈希
+struct OpusFileKey {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t head_hash;           // 文件开头一段的哈希（未启用时为 0）
+    uint64_t tail_hash;           // 文件末尾一段的哈希（未启用时为 0）
+};
+
+/**
+ * 读取已打开文件的身份
+ * @param fd 文件描述符
+ * @param use_content_hash 是否计算首尾内容的哈希
+ * @param hash_end 哈希的末尾一段截止的位置（0 表示文件末尾；检查追加时为原来的文件大小）
+ * @param key 输出：文件身份
+ * @return 是否成功
+ */
+bool getFileKey(int fd, bool use_content_hash, uint64_t hash_end, OpusFileKey& key);
+
+/**
+ * 分析结果缓存
+ * 每个文件一个缓存条目，存放在缓存目录下按 inode 分片的子目录中，
+ * 文件名由设备号和 inode 组成。条目写入临时文件后再重命名，中途中断不会留下损坏的条目。
+ */
+class OpusAnalysisCache {
+public:
+    /**
+     * @param dir 缓存目录（不存在时自动创建）
+     * @param use_content_hash 是否额外比较文件首尾内容的哈希
+     */
+    OpusAnalysisCache(const std::string& dir, bool use_content_hash);
+
+    /**
+     * 获取文件的分析结果
+     * 文件未变化时直接返回缓存；开启内容哈希且文件只是被追加时从上次的检查点继续分析；否则重新分析。
+     * @param path 文件路径
+     * @param analysis 输出：分析结果
+     * @param status 输出：缓存查询结果（可为 nullptr）
+     * @return 是否成功
+     */
+    bool analyze(const char* path, OpusFileAnalysis& analysis, OpusCacheStatus* status);
+
+private:
+    bool getFileKey(const char* path, uint64_t hash_end, OpusFileKey& key) const;
+    std::string getEntryPath(const OpusFileKey& key) const;
+    bool loadEntry(const OpusFileKey& key, OpusFileKey& cached_key, OpusFileAnalysis& analysis) const;
+    bool storeEntry(const OpusFileKey& key, const OpusFileAnalysis& analysis) const;
+
+    std::string dir_;
+    bool use_content_hash_;
+};
+
+} // namespace opus_analyzer
@@ -0,0 +1,177 @@
+/*
+ * Opus Analyzer C API
+ * C 接口实现
+ */
+
+#include "opus_analyzer_c.h"
+#include "opus_packet_stream.h"
+#include "opus_utils.h"
+#include <new>
+
+using namespace opus_analyzer;
+
+struct opus_analyzer_stream {
+    OpusPacketStream stream;
+};
+
+namespace {
+
+uint8_t getFlags(const OpusFrameInfo& frame_info) {
+    uint8_t flags = 0;
+    if (frame_info.has_padding) flags |= OPUS_ANALYZER_FLAG_PADDING;
+    if (frame_info.is_self_delimiting) flags |= OPUS_ANALYZER_FLAG_SELF_DELIMITING;
+    if (frame_info.frame_count_code == 3 && frame_info.is_cbr) flags |= OPUS_ANALYZER_FLAG_CBR;
+    if (frame_info.stereo) flags |= OPUS_ANALYZER_FLAG_STEREO;
+    return flags;
+}
+
+// 写入第 i 个包，跳过为 NULL 的列
+void storePacket(opus_analyzer_packets* packets, size_t i, const OpusStreamPacket& packet) {
+    const OpusFrameInfo& frame_info = packet.frame_info;
+    if (packets->offset != nullptr) packets->offset[i] = packet.offset;
+    if (packets->size != nullptr) packets->size[i] = packet.size;
+    if (packets->toc != nullptr) packets->toc[i] = frame_info.toc_byte;
+    if (packets->flags != nullptr) packets->flags[i] = getFlags(frame_info);
+    if (packets->frame_count != nullptr) packets->frame_count[i] = static_cast<uint8_t>(frame_info.frame_count);
+    if (packets->samples != nullptr) {
+        packets->samples[i] = getFrameSamples(frame_info.frame_size) * frame_info.frame_count;
+    }
+    if (packets->padding != nullptr) packets->padding[i] = frame_info.padding_size;
+}
+
+// 从流中读取一批包
+int readPackets(OpusPacketStream& stream, opus_analyzer_packets* packets) {
+    // 目前只有一个版本的结构体；大小未知时不能访问其他字段
+    if (packets->struct_size != sizeof(opus_analyzer_packets)) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    packets->count = 0;
+    if (packets->capacity == 0) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;   // 否则永远返回 OPUS_ANALYZER_MORE
+    }
+    OpusStreamPacket packet;
+    while (packets->count < packets->capacity) {
+        if (!stream.next(packet)) {
+            if (stream.hasError()) {
+                return OPUS_ANALYZER_ERROR_IO;
+            }
+            return stream.needsData() ? OPUS_ANALYZER_NEED_DATA : OPUS_ANALYZER_END;
+        }
+        storePacket(packets, packets->count, packet);
+        packets->count++;
+    }
+    return OPUS_ANALYZER_MORE;
+}
+
+} // namespace
+
+int opus_analyzer_abi_version(void) {
+    return OPUS_ANALYZER_ABI_VERSION;
+}
+
+int opus_analyzer_parse_buffer(const uint8_t* data, size_t length, opus_analyzer_packets* packets,
+                               size_t* consumed, uint64_t* skipped) {
+    if (packets == nullptr || (data == nullptr && length > 0)) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    try {
+        OpusPacketStream stream;
+        stream.attach(data, length, 0);
+        int result = readPackets(stream, packets);
+        if (consumed != nullptr) {
+            *consumed = static_cast<size_t>(stream.position());
+        }
+        if (skipped != nullptr) {
+            *skipped = stream.skippedBytes();
+        }
+        return result;
+    } catch (...) {
+        return OPUS_ANALYZER_ERROR_MEMORY;
+    }
+}
+
+int opus_analyzer_parse_file(const char* path, uint64_t offset, opus_analyzer_packets* packets,
+                             uint64_t* consumed, uint64_t* skipped) {
+    if (path == nullptr || packets == nullptr) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    try {
+        OpusPacketStream stream;
+        if (!stream.open(path, offset)) {
+            return OPUS_ANALYZER_ERROR_IO;
+        }
+        int result = readPackets(stream, packets);
+        if (consumed != nullptr) {
+            *consumed = stream.position() - offset;
+        }
+        if (skipped != nullptr) {
+            *skipped = stream.skippedBytes();
+        }
+        return result;
+    } catch (...) {
+        return OPUS_ANALYZER_ERROR_MEMORY;
+    }
+}
+
+opus_analyzer_stream* opus_analyzer_stream_open_file(const char* path) {
+    if (path == nullptr) {
+        return nullptr;
+    }
+    try {
+        opus_analyzer_stream* stream = new opus_analyzer_stream();
+        if (!stream->stream.open(path, 0)) {
+            delete stream;
+            return nullptr;
+        }
+        return stream;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+opus_analyzer_stream* opus_analyzer_stream_new(void) {
+    opus_analyzer_stream* stream = new (std::nothrow) opus_analyzer_stream();
+    if (stream != nullptr) {
+        stream->stream.openFeed();
+    }
+    return stream;
+}
+
+int opus_analyzer_stream_feed(opus_analyzer_stream* stream, const uint8_t* data, size_t length) {
+    if (stream == nullptr || (data == nullptr && length > 0)) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    try {
+        stream->stream.feed(data, length);
+        return OPUS_ANALYZER_OK;
+    } catch (...) {
+        return OPUS_ANALYZER_ERROR_MEMORY;
+    }
+}
+
+int opus_analyzer_stream_finish(opus_analyzer_stream* stream) {
+    if (stream == nullptr) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    stream->stream.finish();
+    return OPUS_ANALYZER_OK;
+}
+
+int opus_analyzer_stream_read(opus_analyzer_stream* stream, opus_analyzer_packets* packets) {
+    if (stream == nullptr || packets == nullptr) {
+        return OPUS_ANALYZER_ERROR_ARGUMENT;
+    }
+    try {
+        return readPackets(stream->stream, packets);
+    } catch (...) {
+        return OPUS_ANALYZER_ERROR_MEMORY;
+    }
+}
+
+uint64_t opus_analyzer_stream_skipped(const opus_analyzer_stream* stream) {
+    return stream != nullptr ? stream->stream.skippedBytes() : 0;
+}
+
+void opus_analyzer_stream_free(opus_analyzer_stream* stream) {
+    delete stream;
+}
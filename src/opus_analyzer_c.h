@@ -0,0 +1,155 @@
+/*
+ * Opus Analyzer C API
+ * 稳定的 C 接口：一次调用解析一批包，结果写入调用方提供的列数组（每列一个数组），便于其他语言绑定
+ *
+ * 约定：
+ *   - 所有内存由调用方分配，库不保留调用方的指针；
+ *   - opus_analyzer_packets 的 struct_size 必须设为 sizeof(opus_analyzer_packets)，不需要的列可以设为 NULL；
+ *   - 以后只会在结构体末尾追加新列，并增加 OPUS_ANALYZER_ABI_VERSION，库根据 struct_size 识别调用方使用的版本；
+ *   - 接口不会抛出 C++ 异常。
+ */
+
+#ifndef OPUS_ANALYZER_C_H
+#define OPUS_ANALYZER_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define OPUS_ANALYZER_EXPORT __declspec(dllexport)
+#else
+#define OPUS_ANALYZER_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPUS_ANALYZER_ABI_VERSION 3
+
+/* 返回值 */
+#define OPUS_ANALYZER_OK 0
+#define OPUS_ANALYZER_MORE 1               /* 列数组已满，还有更多包 */
+#define OPUS_ANALYZER_NEED_DATA 2          /* 已返回所有完整的包，需要送入更多数据 */
+#define OPUS_ANALYZER_END 3                /* 流已结束，所有包都已返回 */
+#define OPUS_ANALYZER_ERROR_ARGUMENT (-1)  /* 参数无效 */
+#define OPUS_ANALYZER_ERROR_IO (-2)        /* 打开或读取文件失败 */
+#define OPUS_ANALYZER_ERROR_MEMORY (-3)    /* 内存不足 */
+
+/* 包标志位（flags 列） */
+#define OPUS_ANALYZER_FLAG_PADDING 0x01          /* 有填充字节 */
+#define OPUS_ANALYZER_FLAG_SELF_DELIMITING 0x02  /* 带分界包 */
+#define OPUS_ANALYZER_FLAG_CBR 0x04              /* 3 号包 CBR */
+#define OPUS_ANALYZER_FLAG_STEREO 0x08           /* 立体声 */
+
+/*
+ * 一批包的列数组：每列是长度为 capacity 的数组，下标相同的元素属于同一个包
+ * config、编码模式、带宽和帧长度都可以由 TOC 字节得到，因此不单独成列。
+ * struct_size 不是已知的结构体大小或 capacity 为 0 时，各接口返回 OPUS_ANALYZER_ERROR_ARGUMENT。
+ */
+typedef struct opus_analyzer_packets {
+    size_t struct_size;       /* 输入：sizeof(opus_analyzer_packets) */
+    size_t capacity;          /* 输入：每列的容量（包数） */
+    size_t count;             /* 输出：写入的包数 */
+    uint64_t* offset;         /* 包的偏移（相对于流的开头） */
+    uint32_t* size;           /* 包长度（字节） */
+    uint8_t* toc;             /* TOC 字节 */
+    uint8_t* flags;           /* OPUS_ANALYZER_FLAG_* */
+    uint8_t* frame_count;     /* 帧数 */
+    uint32_t* samples;        /* 包的采样数（48 kHz） */
+    uint32_t* padding;        /* 填充字节数 */
+} opus_analyzer_packets;
+
+/* 流句柄 */
+typedef struct opus_analyzer_stream opus_analyzer_stream;
+
+/**
+ * 获取库的 ABI 版本
+ * @return OPUS_ANALYZER_ABI_VERSION
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_abi_version(void);
+
+/**
+ * 解析内存中的 Opus 裸流，直到数据结束或列数组已满
+ * 返回 OPUS_ANALYZER_MORE 时，可以用 data + *consumed 再次调用继续解析（偏移相对于新的起点）。
+ * @param data 流数据
+ * @param length 数据长度
+ * @param packets 输入/输出：列数组
+ * @param consumed 输出：已处理的字节数（可为 NULL）
+ * @param skipped 输出：无法解析而跳过的字节数（可为 NULL）
+ * @return OPUS_ANALYZER_END、OPUS_ANALYZER_MORE 或错误码
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_parse_buffer(const uint8_t* data, size_t length,
+                                                    opus_analyzer_packets* packets,
+                                                    size_t* consumed, uint64_t* skipped);
+
+/**
+ * 从 offset 处开始解析 Opus 裸流文件，直到文件结束或列数组已满
+ * 包的偏移是文件中的绝对偏移。返回 OPUS_ANALYZER_MORE 时，可以用 offset + *consumed 再次调用继续解析。
+ * @param path 文件路径
+ * @param offset 起始位置（应为包边界，文件开头为 0）
+ * @param packets 输入/输出：列数组
+ * @param consumed 输出：从 offset 开始已处理的字节数（可为 NULL）
+ * @param skipped 输出：无法解析而跳过的字节数（可为 NULL）
+ * @return OPUS_ANALYZER_END、OPUS_ANALYZER_MORE 或错误码
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_parse_file(const char* path, uint64_t offset, opus_analyzer_packets* packets,
+                                                  uint64_t* consumed, uint64_t* skipped);
+
+/**
+ * 打开文件流，之后用 opus_analyzer_stream_read 分批读取
+ * @param path 文件路径
+ * @return 流句柄，失败时返回 NULL
+ */
+OPUS_ANALYZER_EXPORT opus_analyzer_stream* opus_analyzer_stream_open_file(const char* path);
+
+/**
+ * 创建由调用方送入数据的流
+ * @return 流句柄，失败时返回 NULL
+ */
+OPUS_ANALYZER_EXPORT opus_analyzer_stream* opus_analyzer_stream_new(void);
+
+/**
+ * 送入数据（复制到内部缓冲区）
+ * 起始于已送入数据末尾 128KB 内的包，要等送入更多数据或调用 opus_analyzer_stream_finish 后才会返回。
+ * @param stream 流句柄
+ * @param data 数据
+ * @param length 数据长度
+ * @return OPUS_ANALYZER_OK 或错误码
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_stream_feed(opus_analyzer_stream* stream, const uint8_t* data,
+                                                   size_t length);
+
+/**
+ * 标记数据已全部送入
+ * @param stream 流句柄
+ * @return OPUS_ANALYZER_OK 或错误码
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_stream_finish(opus_analyzer_stream* stream);
+
+/**
+ * 读取一批包
+ * @param stream 流句柄
+ * @param packets 输入/输出：列数组
+ * @return OPUS_ANALYZER_MORE、OPUS_ANALYZER_NEED_DATA、OPUS_ANALYZER_END 或错误码
+ */
+OPUS_ANALYZER_EXPORT int opus_analyzer_stream_read(opus_analyzer_stream* stream, opus_analyzer_packets* packets);
+
+/**
+ * 获取到目前为止无法解析而跳过的字节数
+ * @param stream 流句柄
+ * @return 跳过的字节数
+ */
+OPUS_ANALYZER_EXPORT uint64_t opus_analyzer_stream_skipped(const opus_analyzer_stream* stream);
+
+/**
+ * 关闭流并释放句柄
+ * @param stream 流句柄（可为 NULL）
+ */
+OPUS_ANALYZER_EXPORT void opus_analyzer_stream_free(opus_analyzer_stream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPUS_ANALYZER_C_H */
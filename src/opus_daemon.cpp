@@ -0,0 +1,381 @@
+/*
+ * Opus Daemon
+ * 常驻分析服务实现
+ */
+
+#include "opus_daemon.h"
+#include "opus_trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint32_t kMaxRequestSize = 64 * 1024;
+const uint32_t kMaxResponseSize = 64 * 1024 * 1024; // 结果主要是定位点（每秒一个，变长编码约 8 字节），足够上千小时的文件
+const size_t kHeaderSize = 1 + 8;          // 类型 + 参数
+const int kMaxEvents = 64;                 // 每次 epoll_wait 最多取出的事件数
+const int kIoTimeoutSeconds = 5;           // 工作线程读写一个连接的超时
+
+void putLE32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+uint32_t getLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void putLE64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+uint64_t getLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+}
+
+bool recvFully(int fd, uint8_t* data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = recv(fd, data + done, length - done, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool sendFully(int fd, const uint8_t* data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = send(fd, data + done, length - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 读取一帧：u32 长度 + 数据
+bool recvFrame(int fd, std::vector<uint8_t>& frame, uint32_t max_size) {
+    uint8_t length[4];
+    if (!recvFully(fd, length, sizeof(length))) {
+        return false;
+    }
+    uint32_t size = getLE32(length);
+    if (size > max_size) {
+        return false;
+    }
+    frame.resize(size);
+    return size == 0 || recvFully(fd, &frame[0], size);
+}
+
+// 写出一帧：u32 长度 + 数据（data 的前 4 字节预留给长度）
+bool sendFrame(int fd, std::vector<uint8_t>& data) {
+    putLE32(&data[0], static_cast<uint32_t>(data.size() - 4));
+    return sendFully(fd, data.data(), data.size());
+}
+
+bool makeAddress(const char* socket_path, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    strcpy(addr.sun_path, socket_path);
+    return true;
+}
+
+} // namespace
+
+void getDefaultDaemonConfig(OpusDaemonConfig& config) {
+    config.socket_path.clear();
+    unsigned cpus = std::thread::hardware_concurrency();
+    config.worker_count = cpus > 0 ? cpus : 4;
+    config.cache_bytes = static_cast<size_t>(1) << 30;
+    config.queue_capacity = 1024;
+}
+
+OpusAnalyzerDaemon::OpusAnalyzerDaemon(const OpusDaemonConfig& config)
+    : config_(config), cache_(config.cache_bytes), queue_(config.queue_capacity),
+      stopping_(false), listen_fd_(-1), epoll_fd_(-1), wake_fd_(-1) {
+}
+
+OpusAnalyzerDaemon::~OpusAnalyzerDaemon() {
+    stop();
+    // 每个工作线程收到一个 -1 后退出；之前入队的连接已被 shutdown，读取立即失败并关闭
+    for (size_t i = 0; i < workers_.size(); i++) {
+        queue_.push(-1);
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i].join();
+    }
+    // 剩下的是空闲的连接
+    for (std::set<int>::iterator it = conn_fds_.begin(); it != conn_fds_.end(); ++it) {
+        close(*it);
+    }
+    conn_fds_.clear();
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(config_.socket_path.c_str());
+    }
+}
+
+bool OpusAnalyzerDaemon::start() {
+    struct sockaddr_un addr;
+    if (!makeAddress(config_.socket_path.c_str(), addr)) {
+        return false;
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    unlink(config_.socket_path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 64) != 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        return false;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) != 0) {
+        return false;
+    }
+    event.data.fd = wake_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+        return false;
+    }
+
+    uint32_t worker_count = config_.worker_count > 0 ? config_.worker_count : 1;
+    for (uint32_t i = 0; i < worker_count; i++) {
+        workers_.push_back(std::thread(&OpusAnalyzerDaemon::workerLoop, this));
+    }
+    return true;
+}
+
+void OpusAnalyzerDaemon::run() {
+    struct epoll_event events[kMaxEvents];
+    while (!stopping_.load()) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                continue;         // stop 唤醒，回到循环条件
+            }
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+            // 连接可读或已断开：交给工作线程处理一个请求（EPOLLONESHOT，处理完之前不会再次报告）
+            queue_.push(fd);
+        }
+    }
+}
+
+void OpusAnalyzerDaemon::acceptConnections() {
+    while (1) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;               // EAGAIN：没有更多连接
+        }
+        // 工作线程以阻塞方式读写：设置超时，请求不完整或不读取响应的客户端不会一直占用工作线程
+        struct timeval timeout;
+        timeout.tv_sec = kIoTimeoutSeconds;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (stopping_.load()) {
+            close(fd);
+            return;
+        }
+        conn_fds_.insert(fd);
+        if (!watchConnection(fd, EPOLL_CTL_ADD)) {
+            conn_fds_.erase(fd);
+            close(fd);
+        }
+    }
+}
+
+bool OpusAnalyzerDaemon::watchConnection(int fd, int op) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd_, op, fd, &event) == 0;
+}
+
+void OpusAnalyzerDaemon::stop() {
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    stopping_.store(true);
+    // 唤醒 epoll_wait 和正在读写连接的工作线程
+    if (wake_fd_ >= 0) {
+        eventfd_write(wake_fd_, 1);
+    }
+    for (std::set<int>::iterator it = conn_fds_.begin(); it != conn_fds_.end(); ++it) {
+        shutdown(*it, SHUT_RDWR);
+    }
+}
+
+void OpusAnalyzerDaemon::workerLoop() {
+    OPUS_TRACE_THREAD("worker");
+    while (1) {
+        int fd = queue_.pop();
+        if (fd < 0) {
+            break;
+        }
+        // 处理一个请求后重新监视；连接关闭或出错时关闭
+        if (!serveRequest(fd) || !watchConnection(fd, EPOLL_CTL_MOD)) {
+            closeConnection(fd);
+        }
+    }
+}
+
+bool OpusAnalyzerDaemon::serveRequest(int fd) {
+    std::vector<uint8_t> frame;
+    if (!recvFrame(fd, frame, kMaxRequestSize) || frame.size() < kHeaderSize) {
+        return false;
+    }
+    Request request;
+    request.type = frame[0];
+    request.arg = getLE64(&frame[1]);
+    request.path.assign(reinterpret_cast<const char*>(&frame[kHeaderSize]), frame.size() - kHeaderSize);
+    request.status = OPUS_DAEMON_ERROR;
+    request.response.assign(5, 0);    // 长度和状态，结果追加在后面
+
+    handleRequest(request);
+
+    request.response[4] = request.status;
+    OPUS_TRACE_SCOPE("send");
+    return sendFrame(fd, request.response);
+}
+
+void OpusAnalyzerDaemon::closeConnection(int fd) {
+    // 在锁内关闭，stop 不会 shutdown 一个已被复用的描述符
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    conn_fds_.erase(fd);
+    close(fd);
+}
+
+void OpusAnalyzerDaemon::handleRequest(Request& request) {
+    OPUS_TRACE_SCOPE("request");
+    std::shared_ptr<OpusCachedFile> file = cache_.open(request.path);
+    std::shared_ptr<const OpusFileAnalysis> analysis;
+    if (!file || !cache_.getAnalysis(file, analysis)) {
+        return;
+    }
+
+    switch (request.type) {
+    case OPUS_DAEMON_ANALYZE:
+        serializeFileAnalysis(*analysis, request.response);
+        break;
+    case OPUS_DAEMON_SUMMARY:
+        serializeStreamSummary(analysis->summary, request.response);
+        break;
+    case OPUS_DAEMON_SEEK: {
+        // 最后一个 sample <= arg 的定位点
+        const std::vector<OpusSeekPoint>& index = analysis->index;
+        size_t lo = 0;
+        size_t hi = index.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (index[mid].sample <= request.arg) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == 0) {
+            return;
+        }
+        const OpusSeekPoint& point = index[lo - 1];
+        putLE64(request.response, point.offset);
+        putLE64(request.response, point.sample);
+        putLE64(request.response, point.packet);
+        break;
+    }
+    default:
+        return;
+    }
+    request.status = OPUS_DAEMON_OK;
+}
+
+bool opusDaemonRequest(const char* socket_path, uint8_t type, const std::string& path, uint64_t arg,
+                       uint8_t& status, std::vector<uint8_t>& response) {
+    struct sockaddr_un addr;
+    if (!makeAddress(socket_path, addr)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::vector<uint8_t> frame(4);
+    frame.push_back(type);
+    putLE64(frame, arg);
+    frame.insert(frame.end(), path.begin(), path.end());
+    bool ok = sendFrame(fd, frame) && recvFrame(fd, response, kMaxResponseSize) && !response.empty();
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+    status = response[0];
+    response.erase(response.begin());
+    return true;
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,118 @@
+/*
+ * Opus Daemon
+ * 常驻分析服务：通过 Unix 套接字接收分析/定位/摘要请求
+ *
+ * 请求：u32 长度（小端，不含自身） + u8 类型 + u64 参数（小端） + 文件路径
+ * 响应：u32 长度（小端，不含自身） + u8 状态 + 结果数据
+ *   ANALYZE：serializeFileAnalysis 的结果
+ *   SUMMARY：serializeStreamSummary 的结果
+ *   SEEK：参数为采样位置（48kHz），结果为不超过该位置的最后一个定位点，3 个 u64（小端）：偏移、采样位置、包序号
+ */
+
+#pragma once
+
+#include "opus_file_cache.h"
+#include "opus_mpmc_queue.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 请求类型
+const uint8_t OPUS_DAEMON_ANALYZE = 1;
+const uint8_t OPUS_DAEMON_SUMMARY = 2;
+const uint8_t OPUS_DAEMON_SEEK = 3;
+
+// 响应状态
+const uint8_t OPUS_DAEMON_OK = 0;
+const uint8_t OPUS_DAEMON_ERROR = 1;
+
+// 服务配置
+struct OpusDaemonConfig {
+    std::string socket_path;      // Unix 套接字路径
+    uint32_t worker_count;        // 工作线程数
+    size_t cache_bytes;           // 缓存的热点文件总大小上限
+    size_t queue_capacity;        // 待处理连接队列容量
+};
+
+/**
+ * 获取默认服务配置（工作线程数为 CPU 数，缓存上限 1GB）
+ * @param config 输出：配置
+ */
+void getDefaultDaemonConfig(OpusDaemonConfig& config);
+
+/**
+ * 常驻分析服务
+ * 调用 run 的线程用 epoll 监视监听套接字和所有连接，连接可读时放入队列；常驻的工作线程从队列取出连接，
+ * 读取一个请求、执行分析、写回响应后重新监视该连接。线程数固定，不随连接数增长，空闲连接只占一个文件描述符。
+ * 文件的分析结果按路径缓存，热点文件的请求不需要重新读取和解析。
+ */
+class OpusAnalyzerDaemon {
+public:
+    explicit OpusAnalyzerDaemon(const OpusDaemonConfig& config);
+    ~OpusAnalyzerDaemon();
+
+    /**
+     * 创建套接字并启动工作线程
+     * @return 是否成功
+     */
+    bool start();
+
+    /**
+     * 接受连接并分发可读的连接，直到 stop 被调用
+     */
+    void run();
+
+    /**
+     * 停止服务（可以在其他线程调用）
+     */
+    void stop();
+
+private:
+    struct Request {
+        uint8_t type;
+        uint64_t arg;
+        std::string path;
+        uint8_t status;
+        std::vector<uint8_t> response;
+    };
+
+    void workerLoop();
+    void acceptConnections();
+    bool watchConnection(int fd, int op);
+    bool serveRequest(int fd);
+    void closeConnection(int fd);
+    void handleRequest(Request& request);
+
+    OpusDaemonConfig config_;
+    OpusFileCache cache_;
+    MpmcQueue<int> queue_;        // 可读的连接，-1 通知工作线程退出
+    std::vector<std::thread> workers_;
+    std::atomic<bool> stopping_;
+    std::mutex conn_mutex_;       // 保护 conn_fds_
+    std::set<int> conn_fds_;      // 已接受的连接
+    int listen_fd_;
+    int epoll_fd_;
+    int wake_fd_;                 // stop 通过它唤醒 epoll_wait
+};
+
+/**
+ * 向服务发送一个请求并等待响应
+ * @param socket_path Unix 套接字路径
+ * @param type 请求类型
+ * @param path 文件路径
+ * @param arg 请求参数
+ * @param status 输出：响应状态
+ * @param response 输出：结果数据
+ * @return 是否成功收到响应
+ */
+bool opusDaemonRequest(const char* socket_path, uint8_t type, const std::string& path, uint64_t arg,
+                       uint8_t& status, std::vector<uint8_t>& response);
+
+} // namespace opus_analyzer
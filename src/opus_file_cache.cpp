@@ -0,0 +1,138 @@
+/*
+ * Opus File Cache
+ * 热点文件缓存实现
+ */
+
+#include "opus_file_cache.h"
+#include "opus_trace.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+// 设备号、inode、大小和修改时间都相同
+bool isSameFile(const OpusFileKey& a, const OpusFileKey& b) {
+    return a.device == b.device && a.inode == b.inode && a.size == b.size && a.mtime_ns == b.mtime_ns;
+}
+
+} // namespace
+
+OpusCachedFile::OpusCachedFile()
+    : analyzed(false) {
+    memset(&key, 0, sizeof(key));
+}
+
+OpusFileCache::OpusFileCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes), cached_bytes_(0) {
+}
+
+std::shared_ptr<OpusCachedFile> OpusFileCache::open(const std::string& path) {
+    OPUS_TRACE_SCOPE("open");
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::shared_ptr<OpusCachedFile>();
+    }
+    OpusFileKey key;
+    if (!getFileKey(fd, false, 0, key)) {
+        close(fd);
+        return std::shared_ptr<OpusCachedFile>();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::shared_ptr<OpusCachedFile> old;
+    std::unordered_map<std::string, FileList::iterator>::iterator it = files_.find(path);
+    if (it != files_.end()) {
+        std::shared_ptr<OpusCachedFile> file = *it->second;
+        if (isSameFile(file->key, key)) {
+            // 命中：移到最前
+            lru_.splice(lru_.begin(), lru_, it->second);
+            close(fd);
+            return file;
+        }
+        // 文件已变化：丢弃旧条目（仍在使用的请求持有引用，不受影响）
+        old = file;
+        cached_bytes_ -= static_cast<size_t>(file->key.size);
+        lru_.erase(it->second);
+        files_.erase(it);
+    }
+    lock.unlock();
+
+    // 新条目记录首尾内容的哈希；同一文件变大时，核对原有部分的首尾内容确认只是被追加
+    std::shared_ptr<OpusCachedFile> file = std::make_shared<OpusCachedFile>();
+    file->path = path;
+    bool appended = false;
+    {
+        OPUS_TRACE_SCOPE("hash");
+        if (!getFileKey(fd, true, 0, file->key)) {
+            close(fd);
+            return std::shared_ptr<OpusCachedFile>();
+        }
+        OpusFileKey old_key;
+        appended = old && old->key.device == file->key.device && old->key.inode == file->key.inode &&
+                   file->key.size > old->key.size && getFileKey(fd, true, old->key.size, old_key) &&
+                   old_key.head_hash == old->key.head_hash && old_key.tail_hash == old->key.tail_hash;
+    }
+    close(fd);
+    if (appended) {
+        // 沿用旧的分析结果，之后从检查点继续
+        std::lock_guard<std::mutex> old_lock(old->mutex);
+        if (old->analyzed) {
+            file->analysis = old->analysis;
+        }
+    }
+
+    lock.lock();
+    it = files_.find(path);
+    if (it != files_.end()) {
+        // 其他线程已经加入了同一文件
+        std::shared_ptr<OpusCachedFile> other = *it->second;
+        if (isSameFile(other->key, file->key)) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return other;
+        }
+        cached_bytes_ -= static_cast<size_t>(other->key.size);
+        lru_.erase(it->second);
+        files_.erase(it);
+    }
+    lru_.push_front(file);
+    files_[path] = lru_.begin();
+    cached_bytes_ += static_cast<size_t>(file->key.size);
+    evict();
+    return file;
+}
+
+void OpusFileCache::evict() {
+    // 至少保留刚加入的文件
+    while (cached_bytes_ > capacity_bytes_ && lru_.size() > 1) {
+        std::shared_ptr<OpusCachedFile> file = lru_.back();
+        cached_bytes_ -= static_cast<size_t>(file->key.size);
+        files_.erase(file->path);
+        lru_.pop_back();
+    }
+}
+
+bool OpusFileCache::getAnalysis(const std::shared_ptr<OpusCachedFile>& file,
+                                std::shared_ptr<const OpusFileAnalysis>& analysis) {
+    std::lock_guard<std::mutex> lock(file->mutex);
+    if (!file->analyzed) {
+        // 在新对象上分析（有旧结果时从其检查点继续），完成后再发布
+        std::shared_ptr<OpusFileAnalysis> result = std::make_shared<OpusFileAnalysis>();
+        if (file->analysis) {
+            *result = *file->analysis;
+        } else {
+            resetFileAnalysis(*result);
+        }
+        if (!analyzeOpusFile(file->path.c_str(), *result)) {
+            return false;
+        }
+        file->analysis = result;
+        file->analyzed = true;
+    }
+    analysis = file->analysis;
+    return true;
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,76 @@
+/*
+ * Opus File Cache
+ * 热点文件的分析结果缓存
+ */
+
+#pragma once
+
+#include "opus_analysis_cache.h"
+#include "opus_stream_analyzer.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace opus_analyzer {
+
+// 缓存的文件
+struct OpusCachedFile {
+    std::string path;
+    OpusFileKey key;              // 文件身份，含加入缓存时首尾内容的哈希
+
+    std::mutex mutex;             // 保护下面的分析结果
+    bool analyzed;
+    std::shared_ptr<const OpusFileAnalysis> analysis; // 分析结果；分析前为同一文件变大前的结果（可为空）
+
+    OpusCachedFile();
+};
+
+/**
+ * 热点文件缓存
+ * 按路径缓存文件的分析结果，缓存的文件总大小超过上限时淘汰最久未使用的文件。
+ * 每次取用都会 stat 检查文件是否变化；文件变大且原有部分首尾内容的哈希不变（被追加）时，
+ * 沿用旧的分析结果从检查点继续，否则重新分析。
+ * 分析时通过 OpusPacketStream 读取文件（文件内容由系统页缓存保留），不映射文件：
+ * 文件在分析过程中被截断只会让读取提前结束，下次取用时因大小变化重新分析。
+ * 可以被多个线程同时使用。
+ */
+class OpusFileCache {
+public:
+    /**
+     * @param capacity_bytes 缓存的文件总大小上限
+     */
+    explicit OpusFileCache(size_t capacity_bytes);
+
+    /**
+     * 获取缓存的文件
+     * @param path 文件路径
+     * @return 缓存的文件，失败时返回空指针
+     */
+    std::shared_ptr<OpusCachedFile> open(const std::string& path);
+
+    /**
+     * 获取文件的分析结果（同一文件只分析一次）
+     * 结果创建后不再修改，多个请求共享同一份，锁内只复制指针。
+     * @param file 缓存的文件
+     * @param analysis 输出：分析结果
+     * @return 是否成功
+     */
+    bool getAnalysis(const std::shared_ptr<OpusCachedFile>& file, std::shared_ptr<const OpusFileAnalysis>& analysis);
+
+private:
+    typedef std::list<std::shared_ptr<OpusCachedFile> > FileList;
+
+    void evict();
+
+    size_t capacity_bytes_;
+    size_t cached_bytes_;
+    std::mutex mutex_;
+    FileList lru_;                // 最近使用的在前
+    std::unordered_map<std::string, FileList::iterator> files_;
+};
+
+} // namespace opus_analyzer
@@ -0,0 +1,196 @@
+/*
+ * Opus Fingerprint
+ * 包指纹与重复片段索引实现
+ */
+
+#include "opus_fingerprint.h"
+#include "opus_frame_header.h"
+#include <string.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kRollBase = 0x100000001B3ULL;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t mixLane(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t readLE64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t finalizeHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace
+
+uint64_t hashPayload(const uint8_t* data, size_t length, uint64_t seed) {
+    // 4 个相互独立的累加器，每轮各处理 8 字节；各路乘法之间没有依赖，可以在流水线中重叠执行
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        v1 = mixLane(v1, readLE64(data + i));
+        v2 = mixLane(v2, readLE64(data + i + 8));
+        v3 = mixLane(v3, readLE64(data + i + 16));
+        v4 = mixLane(v4, readLE64(data + i + 24));
+    }
+    uint64_t h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h += length;
+    for (; i < length; i++) {
+        h = rotl64(h ^ (data[i] * kPrime3), 11) * kPrime1;
+    }
+    return finalizeHash(h);
+}
+
+uint64_t fingerprintPacket(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info) {
+    // TOC 的 config/s 位与帧长度序列
+    uint64_t h = finalizeHash((frame_info.toc_byte >> 2) * kPrime1 + frame_info.frame_sizes.size());
+    for (size_t i = 0; i < frame_info.frame_sizes.size(); i++) {
+        h = rotl64(h ^ (frame_info.frame_sizes[i] * kPrime2), 27) * kPrime1;
+    }
+
+    // 帧数据
+    std::vector<uint32_t> offsets;
+    if (data == nullptr || !getFrameOffsets(frame_info, offsets)) {
+        return finalizeHash(h);
+    }
+    for (size_t i = 0; i < offsets.size(); i++) {
+        if (offsets[i] + frame_info.frame_sizes[i] > length) {
+            break;
+        }
+        h = hashPayload(data + offsets[i], frame_info.frame_sizes[i], h);
+    }
+    return h;
+}
+
+OpusFingerprintIndex::OpusFingerprintIndex(uint32_t kgram, uint32_t max_locations)
+    : kgram_(kgram > 0 ? kgram : 1), max_locations_(max_locations > 0 ? max_locations : 1) {
+}
+
+void OpusFingerprintIndex::closeRun(uint32_t file, uint32_t other_file, const ActiveRun& run) {
+    OpusSharedRun shared;
+    shared.file_a = file;
+    shared.packet_a = run.start;
+    shared.file_b = other_file;
+    shared.packet_b = run.other_start;
+    shared.length = run.last - run.start + kgram_;
+    runs_.push_back(shared);
+}
+
+uint32_t OpusFingerprintIndex::addFile(const std::string& name, const std::vector<uint64_t>& fingerprints) {
+    uint32_t file = static_cast<uint32_t>(files_.size());
+    files_.push_back(name);
+    keys_.push_back(std::vector<uint64_t>());
+    if (fingerprints.size() < kgram_) {
+        return file;
+    }
+
+    // 各 k-gram 的键：kRollBase^kgram 用于从滚动哈希中移除最早的指纹
+    uint64_t base_pow = 1;
+    for (uint32_t i = 0; i < kgram_; i++) {
+        base_pow *= kRollBase;
+    }
+    std::vector<uint64_t>& keys = keys_.back();
+    keys.reserve(fingerprints.size() - kgram_ + 1);
+    uint64_t rolling = 0;
+    for (size_t i = 0; i < fingerprints.size(); i++) {
+        rolling = rolling * kRollBase + fingerprints[i];
+        if (i >= kgram_) {
+            rolling -= fingerprints[i - kgram_] * base_pow;
+        }
+        if (i + 1 >= kgram_) {
+            keys.push_back(finalizeHash(rolling));
+        }
+    }
+
+    // 键：(对方文件, 对方位置 - 本文件位置)
+    typedef std::pair<uint32_t, uint64_t> Diagonal;
+    std::map<Diagonal, ActiveRun> active;
+    for (uint64_t pos = 0; pos < keys.size(); pos++) {
+        uint64_t key = keys[pos];
+
+        // 先延伸正在进行的片段：直接比较对方的下一个 k-gram，不经过索引，
+        // 因此片段可以穿过出现次数达到上限的 k-gram
+        for (std::map<Diagonal, ActiveRun>::iterator it = active.begin(); it != active.end();) {
+            ActiveRun& run = it->second;
+            uint32_t other_file = it->first.first;
+            const std::vector<uint64_t>& other = keys_[other_file];
+            uint64_t other_pos = run.other_start + (pos - run.start);
+            if (other_pos >= other.size() || other[other_pos] != key) {
+                if (!run.full) {
+                    closeRun(file, other_file, run);
+                }
+                active.erase(it++);
+                continue;
+            }
+            if (!run.full && other_file == file && pos + kgram_ > run.start + (run.start - run.other_start)) {
+                // 本文件内的片段不与被重复的部分重叠：长度达到两者的距离时结束，
+                // 但继续占住这条对角线，直到不再相同，避免循环内容在同一对角线上反复报告
+                closeRun(file, other_file, run);
+                run.full = true;
+            }
+            if (!run.full) {
+                run.last = pos;
+            }
+            ++it;
+        }
+
+        // 再查索引，从命中的位置开始新片段。出现次数达到上限的 k-gram（静音等）不再作为起点，
+        // 同时延伸的片段数也不超过 max_locations，避免对角线数量随包数增长
+        std::vector<Location>& locations = index_[key];
+        if (locations.size() >= max_locations_) {
+            continue;
+        }
+        for (size_t j = 0; j < locations.size() && active.size() < max_locations_; j++) {
+            const Location& loc = locations[j];
+            // 本文件内只与不重叠的前面部分比较
+            if (loc.file == file && loc.packet + kgram_ > pos) {
+                continue;
+            }
+            Diagonal diag(loc.file, loc.packet - pos);
+            if (active.find(diag) != active.end()) {
+                continue; // 已在延伸
+            }
+            ActiveRun run;
+            run.start = pos;
+            run.last = pos;
+            run.other_start = loc.packet;
+            run.full = false;
+            active[diag] = run;
+        }
+        Location loc;
+        loc.file = file;
+        loc.packet = pos;
+        locations.push_back(loc);
+    }
+    for (std::map<Diagonal, ActiveRun>::iterator it = active.begin(); it != active.end(); ++it) {
+        if (!it->second.full) {
+            closeRun(file, it->first.first, it->second);
+        }
+    }
+    return file;
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,105 @@
+/*
+ * Opus Fingerprint
+ * 包指纹与重复片段索引：查找文件之间或文件内部重复的包序列
+ */
+
+#pragma once
+
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace opus_analyzer {
+
+/**
+ * 计算包指纹
+ * 由 TOC 的 config/s 位、各帧长度和帧数据的哈希组成，不包含帧数代码、帧长度字段和填充字节，
+ * 因此同一个包转换为带分界包或去除填充后指纹不变。
+ * @param data Opus 包数据（从 TOC 开始）
+ * @param length 数据长度
+ * @param frame_info parseOpusPacket 的解析结果
+ * @return 指纹
+ */
+uint64_t fingerprintPacket(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info);
+
+/**
+ * 数据哈希（4 个独立的 64 位累加器，每次处理 32 字节）
+ * @param data 数据
+ * @param length 数据长度
+ * @param seed 种子
+ * @return 哈希值
+ */
+uint64_t hashPayload(const uint8_t* data, size_t length, uint64_t seed);
+
+// 重复片段：file_a 从 packet_a 开始的 length 个包与 file_b 从 packet_b 开始的相同
+struct OpusSharedRun {
+    uint32_t file_a;
+    uint64_t packet_a;
+    uint32_t file_b;
+    uint64_t packet_b;
+    uint64_t length;
+};
+
+/**
+ * 指纹索引
+ * 以连续 kgram 个包指纹的滚动哈希为键建立索引。加入文件时先查询已有内容（包括本文件前面的部分），
+ * 沿同一对角线连续命中的位置合并为一个重复片段。片段只从出现次数未达上限的 k-gram 开始，
+ * 之后直接与对方的 k-gram 序列比较来延伸（每个文件额外保存每包 8 字节的键）。
+ * 本文件内的片段截断到不与被重复的部分重叠的长度：循环多次的内容在每个循环距离上只报告一个片段。
+ */
+class OpusFingerprintIndex {
+public:
+    /**
+     * @param kgram 组成一个键的连续包数（也是可报告的最短片段长度）
+     * @param max_locations 每个键最多记录的位置数，也是同时延伸的片段数上限（避免静音等重复内容导致索引膨胀）
+     */
+    OpusFingerprintIndex(uint32_t kgram, uint32_t max_locations);
+
+    /**
+     * 加入一个文件的包指纹序列，并查找与已有内容重复的片段
+     * @param name 文件名
+     * @param fingerprints 包指纹序列
+     * @return 文件编号
+     */
+    uint32_t addFile(const std::string& name, const std::vector<uint64_t>& fingerprints);
+
+    /**
+     * 已找到的重复片段（file_a 为后加入的文件）
+     */
+    const std::vector<OpusSharedRun>& runs() const { return runs_; }
+
+    /**
+     * 文件名
+     */
+    const std::string& fileName(uint32_t file) const { return files_[file]; }
+
+private:
+    // 索引中的位置：文件编号和 k-gram 起始包序号
+    struct Location {
+        uint32_t file;
+        uint64_t packet;
+    };
+    // 正在延伸的片段，按 (对方文件, 对角线偏移) 查找
+    struct ActiveRun {
+        uint64_t start;           // 本文件中的起始 k-gram
+        uint64_t last;            // 本文件中最后命中的 k-gram
+        uint64_t other_start;     // 对方的起始 k-gram
+        bool full;                // 本文件内的片段已达到不重叠的最大长度（已报告）
+    };
+
+    void closeRun(uint32_t file, uint32_t other_file, const ActiveRun& run);
+
+    uint32_t kgram_;
+    uint32_t max_locations_;
+    std::vector<std::string> files_;
+    std::vector<std::vector<uint64_t> > keys_;   // 每个文件的 k-gram 键序列
+    std::unordered_map<uint64_t, std::vector<Location> > index_;
+    std::vector<OpusSharedRun> runs_;
+};
+
+} // namespace opus_analyzer
@@ -0,0 +1,172 @@
+/*
+ * Opus Frame Header
+ * 帧头部符号解码实现（参考 RFC 6716 第 4.2.3 节及第 4.3 节）
+ */
+
+#include "opus_frame_header.h"
+#include "opus_range_decoder.h"
+#include <cstring>
+
+namespace opus_analyzer {
+
+namespace {
+
+// SILK LBRR 子帧标志的 iCDF 表（40ms / 60ms）
+const uint8_t kSilkLbrrFlags2Icdf[] = {203, 150, 0};
+const uint8_t kSilkLbrrFlags3Icdf[] = {215, 195, 166, 125, 110, 82, 0};
+
+// CELT 后置滤波器抽头集的 iCDF 表
+const uint8_t kCeltTapsetIcdf[] = {2, 1, 0};
+
+// 每声道 SILK 子帧数（每 20ms 一个）
+uint8_t getSilkFrameCount(OpusFrameSize frame_size) {
+    switch (frame_size) {
+        case OpusFrameSize::FRAME_40_MS: return 2;
+        case OpusFrameSize::FRAME_60_MS: return 3;
+        default: return 1;
+    }
+}
+
+// CELT 帧长度的 LM 值（2.5ms 为 0，每翻倍加 1）
+int getCeltLM(OpusFrameSize frame_size) {
+    switch (frame_size) {
+        case OpusFrameSize::FRAME_2_5_MS: return 0;
+        case OpusFrameSize::FRAME_5_MS: return 1;
+        case OpusFrameSize::FRAME_10_MS: return 2;
+        case OpusFrameSize::FRAME_20_MS: return 3;
+        default: return -1;
+    }
+}
+
+void parseSilkHeader(OpusRangeDecoder& dec, const OpusFrameInfo& frame_info, OpusFrameHeaderInfo& header) {
+    header.has_silk = true;
+    header.silk_channels = frame_info.stereo ? 2 : 1;
+    header.silk_frame_count = getSilkFrameCount(frame_info.frame_size);
+
+    // 各声道：VAD 标志（每子帧一个），然后是 LBRR 标志
+    for (int ch = 0; ch < header.silk_channels; ch++) {
+        for (int i = 0; i < header.silk_frame_count; i++) {
+            header.vad_flags[ch][i] = dec.decodeBitLogp(1);
+        }
+        header.lbrr_flag[ch] = dec.decodeBitLogp(1);
+    }
+
+    // 多子帧时，LBRR 标志为 1 的声道再给出每个子帧的 LBRR 标志
+    for (int ch = 0; ch < header.silk_channels; ch++) {
+        if (!header.lbrr_flag[ch]) {
+            continue;
+        }
+        if (header.silk_frame_count == 1) {
+            header.lbrr_flags[ch][0] = true;
+            continue;
+        }
+        const uint8_t* icdf = header.silk_frame_count == 2 ? kSilkLbrrFlags2Icdf : kSilkLbrrFlags3Icdf;
+        int symbol = dec.decodeIcdf(icdf, 8) + 1;
+        for (int i = 0; i < header.silk_frame_count; i++) {
+            header.lbrr_flags[ch][i] = ((symbol >> i) & 0x01) != 0;
+        }
+    }
+}
+
+void parseCeltHeader(OpusRangeDecoder& dec, const OpusFrameInfo& frame_info, size_t length,
+                     OpusFrameHeaderInfo& header) {
+    header.has_celt = true;
+    int total_bits = static_cast<int>(length * 8);
+    int tell = dec.tell();
+
+    // 静音标志
+    if (tell >= total_bits) {
+        header.celt_silence = true;
+    } else if (tell == 1) {
+        header.celt_silence = dec.decodeBitLogp(15);
+    }
+    if (header.celt_silence) {
+        // 静音帧：剩余比特全部视为已消耗
+        dec.skipToEnd(total_bits);
+        tell = total_bits;
+    }
+
+    // 后置滤波器参数
+    if (tell + 16 <= total_bits) {
+        if (dec.decodeBitLogp(1)) {
+            header.celt_post_filter = true;
+            uint32_t octave = dec.decodeUint(6);
+            header.post_filter_pitch = static_cast<uint16_t>((16 << octave) + dec.decodeBits(4 + octave) - 1);
+            header.post_filter_gain = static_cast<uint8_t>(dec.decodeBits(3));
+            if (dec.tell() + 2 <= total_bits) {
+                header.post_filter_tapset = static_cast<uint8_t>(dec.decodeIcdf(kCeltTapsetIcdf, 2));
+            }
+        }
+        tell = dec.tell();
+    }
+
+    // 瞬态标志（2.5ms 帧没有）
+    if (getCeltLM(frame_info.frame_size) > 0 && tell + 3 <= total_bits) {
+        header.celt_transient = dec.decodeBitLogp(3);
+    }
+}
+
+} // namespace
+
+bool getFrameOffsets(const OpusFrameInfo& frame_info, std::vector<uint32_t>& offsets) {
+    offsets.clear();
+    uint32_t offset = frame_info.data_offset;
+    for (size_t i = 0; i < frame_info.frame_sizes.size(); i++) {
+        offsets.push_back(offset);
+        offset += frame_info.frame_sizes[i];
+    }
+    return frame_info.total_size == 0 || offset <= frame_info.total_size;
+}
+
+bool parseFrameHeader(const uint8_t* frame, size_t length, const OpusFrameInfo& frame_info,
+                      OpusFrameHeaderInfo& header) {
+    memset(&header, 0, sizeof(header));
+    header.frame_length = static_cast<uint32_t>(length);
+
+    // 0/1 字节的帧在解码器中按丢包处理，没有可解码的符号
+    if (length <= 1) {
+        return true;
+    }
+    if (frame == nullptr) {
+        return false;
+    }
+
+    OpusRangeDecoder dec(frame, length);
+    if (frame_info.mode == OpusMode::CELT_ONLY) {
+        parseCeltHeader(dec, frame_info, length, header);
+    } else {
+        parseSilkHeader(dec, frame_info, header);
+    }
+    header.decoded = !dec.hasError();
+    return header.decoded;
+}
+
+bool parseFrameHeaders(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info,
+                       std::vector<OpusFrameHeaderInfo>& headers) {
+    headers.clear();
+    if (data == nullptr) {
+        return false;
+    }
+
+    std::vector<uint32_t> offsets;
+    if (!getFrameOffsets(frame_info, offsets)) {
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < offsets.size(); i++) {
+        uint32_t frame_length = frame_info.frame_sizes[i];
+        if (offsets[i] + frame_length > length) {
+            return false;
+        }
+        OpusFrameHeaderInfo header;
+        if (!parseFrameHeader(data + offsets[i], frame_length, frame_info, header)) {
+            ok = false;
+        }
+        header.frame_offset = offsets[i];
+        headers.push_back(header);
+    }
+    return ok;
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,69 @@
+/*
+ * Opus Frame Header
+ * 读取每帧开头的 SILK/CELT 头部符号（无需完整解码）
+ */
+
+#pragma once
+
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 单帧头部信息
+struct OpusFrameHeaderInfo {
+    uint32_t frame_offset;        // 帧数据相对包起始的偏移
+    uint32_t frame_length;        // 帧数据长度（字节）
+    bool decoded;                 // 是否解码了头部符号（0/1 字节的帧视为丢包/DTX）
+
+    // SILK 层（SILK-only 和 Hybrid）
+    bool has_silk;                // 是否包含 SILK 层
+    uint8_t silk_channels;        // SILK 声道数（1-2）
+    uint8_t silk_frame_count;     // 每声道 SILK 子帧数（1-3，每 20ms 一个）
+    bool vad_flags[2][3];         // 各声道各子帧的 VAD 标志
+    bool lbrr_flag[2];            // 各声道是否带 LBRR（低码率冗余）
+    bool lbrr_flags[2][3];        // 各声道各子帧的 LBRR 标志
+
+    // CELT 层（仅 CELT-only，Hybrid 的 CELT 头部位于 SILK 数据之后）
+    bool has_celt;                // 是否解码了 CELT 头部
+    bool celt_silence;            // 静音标志
+    bool celt_post_filter;        // 是否启用后置滤波器
+    uint16_t post_filter_pitch;   // 后置滤波器基音周期
+    uint8_t post_filter_gain;     // 后置滤波器增益索引 (0-7)
+    uint8_t post_filter_tapset;   // 后置滤波器抽头集 (0-2)
+    bool celt_transient;          // 瞬态标志
+};
+
+/**
+ * 计算包内每帧数据的位置（相对包起始）
+ * @param frame_info parseOpusPacket 的解析结果
+ * @param offsets 输出：每帧的起始偏移
+ * @return 帧数据是否都落在 total_size 范围内
+ */
+bool getFrameOffsets(const OpusFrameInfo& frame_info, std::vector<uint32_t>& offsets);
+
+/**
+ * 解码单帧开头的头部符号
+ * @param frame 帧数据
+ * @param length 帧长度（字节）
+ * @param frame_info 所在包的解析结果（提供模式、帧长度、声道数）
+ * @param header 输出：帧头部信息
+ * @return 是否成功
+ */
+bool parseFrameHeader(const uint8_t* frame, size_t length, const OpusFrameInfo& frame_info,
+                      OpusFrameHeaderInfo& header);
+
+/**
+ * 解码包内所有帧的头部符号
+ * @param data Opus 包数据（从 TOC 开始）
+ * @param length 数据长度
+ * @param frame_info parseOpusPacket 的解析结果
+ * @param headers 输出：每帧的头部信息
+ * @return 是否成功
+ */
+bool parseFrameHeaders(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info,
+                       std::vector<OpusFrameHeaderInfo>& headers);
+
+} // namespace opus_analyzer
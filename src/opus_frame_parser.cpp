@@ -82,12 +82,13 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
             }
 
             // 普通包：剩余所有数据都是帧数据
-            frame_size = length - offset;
-            if (frame_size > 1275) {
+            // 先按 size_t 比较再缩窄，避免超过 4GB 的缓冲区长度被截断
+            if (length - offset > 1275) {
                 return false; // 帧长度不能超过 1275 字节
             }
+            frame_size = static_cast<uint32_t>(length - offset);
             frame_info.frame_sizes.push_back(frame_size);
-            frame_info.total_size = length;
+            frame_info.total_size = static_cast<uint32_t>(length);
             return true;
         }
 
@@ -116,17 +117,17 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
             }
 
             // 普通包：剩余数据平均分成两帧
-            uint32_t remaining = length - offset;
+            size_t remaining = length - offset;
             if (remaining % 2 != 0) {
                 return false; // 必须是偶数
             }
-            frame_size = remaining / 2;
-            if (frame_size > 1275) {
+            if (remaining / 2 > 1275) {
                 return false;
             }
+            frame_size = static_cast<uint32_t>(remaining / 2);
             frame_info.frame_sizes.push_back(frame_size);
             frame_info.frame_sizes.push_back(frame_size);
-            frame_info.total_size = length;
+            frame_info.total_size = static_cast<uint32_t>(length);
             frame_info.frame_count = 2;
             return true;
         }
@@ -172,13 +173,14 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
             if (offset + frame1_size > length) {
                 return false;
             }
-            uint32_t frame2_size = length - offset - frame1_size;
+            size_t frame2_size = length - offset - frame1_size;
             if (frame2_size > 1275) {
                 return false;
             }
             frame_info.frame_sizes.push_back(frame1_size);
-            frame_info.frame_sizes.push_back(frame2_size);
-            frame_info.total_size = length;
+            frame_info.frame_sizes.push_back(static_cast<uint32_t>(frame2_size));
+            frame_info.data_offset = offset;
+            frame_info.total_size = static_cast<uint32_t>(length);
             frame_info.frame_count = 2;
             return true;
         }
@@ -236,7 +238,7 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
                 // VBR：解析前 M-1 个帧的长度
                 // 参考 libopus：last_size = len，然后逐个解析前 M-1 个帧的大小
                 frame_info.frame_sizes.clear();
-                uint32_t last_size = length - offset;  // 剩余的数据大小
+                size_t last_size = length - offset;  // 剩余的数据大小
                 for (uint8_t i = 0; i < frame_count - 1; i++) {
                     if (offset >= length) {
                         return false;
@@ -257,10 +259,10 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
                     last_size -= bytes_read + frame_size;  // 减去已解析的帧大小
                 }
                 
-                if (last_size < 0 || last_size > 1275) {
+                if (last_size > 1275) {
                     return false;
                 }
-                frame_info.frame_sizes.push_back(last_size);
+                frame_info.frame_sizes.push_back(static_cast<uint32_t>(last_size));
             } else {
                 // CBR：所有帧大小相同
                 // 参考 libopus：last_size = len/count
@@ -268,11 +270,11 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
                 
                 // 对于 Opus 裸流，如果传入的 length 太大（整个文件大小），需要先找到包边界
                 size_t packet_size = 0;
-                uint32_t effective_data_size;
+                size_t effective_data_size;
                 
                 // 计算可能的包大小范围
-                uint32_t min_packet_size = offset + frame_count * 10 + padding_size;
-                uint32_t max_packet_size = offset + frame_count * 1275 + padding_size;
+                size_t min_packet_size = offset + frame_count * 10 + padding_size;
+                size_t max_packet_size = offset + frame_count * 1275 + padding_size;
                 
                 // 检查 length 是否在合理范围内
                 size_t original_length = length + padding_size;  // 恢复原始长度（包括填充）
@@ -309,7 +311,7 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
                 }
                 
                 // 使用 libopus 的逻辑：last_size = len/count
-                uint32_t frame_size = effective_data_size / frame_count;
+                size_t frame_size = effective_data_size / frame_count;
                 
                 if (frame_size * frame_count != effective_data_size) {
                     return false;  // 不能整除
@@ -319,11 +321,11 @@ bool parseOpusPacket(const uint8_t* data, size_t length, OpusFrameInfo& frame_in
                 }
                 
                 for (uint8_t i = 0; i < frame_count; i++) {
-                    frame_info.frame_sizes.push_back(frame_size);
+                    frame_info.frame_sizes.push_back(static_cast<uint32_t>(frame_size));
                 }
                 
                 // 设置包的总大小
-                frame_info.total_size = packet_size;
+                frame_info.total_size = static_cast<uint32_t>(packet_size);
             }
 
             frame_info.data_offset = offset;
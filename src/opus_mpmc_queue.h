@@ -0,0 +1,160 @@
+/*
+ * MPMC Queue
+ * 有界多生产者/多消费者无锁队列
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace opus_analyzer {
+
+/**
+ * 有界 MPMC 队列（每个槽位带序号，参考 Dmitry Vyukov 的实现）
+ * 任意多个线程可以同时 push/pop，入队和出队各只需一次 CAS。
+ * 与 SpscQueue 一样，元素一般是句柄；队列满时让出时间片等待，
+ * 队列空时消费者短暂自旋后在条件变量上休眠，由 push 唤醒，空闲的工作线程不占用 CPU。
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    /**
+     * @param capacity 容量（向上取整为 2 的幂）
+     */
+    explicit MpmcQueue(size_t capacity)
+        : cells_(roundUp(capacity)), mask_(cells_.size() - 1), enqueue_pos_(0), dequeue_pos_(0), sleepers_(0) {
+        for (size_t i = 0; i < cells_.size(); i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 尝试入队
+     * @return 队列已满时返回 false
+     */
+    bool tryPush(const T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (1) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 尝试出队
+     * @return 队列为空时返回 false
+     */
+    bool tryPop(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (1) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = cell->data;
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 入队，队列满时阻塞；有休眠的消费者时唤醒一个
+     */
+    void push(const T& value) {
+        for (unsigned spins = 0; !tryPush(value); spins++) {
+            backoff(spins);
+        }
+        // 与 pop 中的屏障配对：要么消费者休眠前能看到新元素，要么这里能看到休眠的消费者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            sleep_cond_.notify_one();
+        }
+    }
+
+    /**
+     * 出队，队列为空时阻塞
+     */
+    T pop() {
+        T value;
+        for (unsigned spins = 0; spins < kSpinCount; spins++) {
+            if (tryPop(value)) {
+                return value;
+            }
+            std::this_thread::yield();
+        }
+        // 休眠：先登记再检查队列，持锁等待，push 在锁内唤醒，不会错过
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!tryPop(value)) {
+            sleep_cond_.wait(lock);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    static const unsigned kSpinCount = 64;  // 休眠前的自旋次数
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    static void backoff(unsigned spins) {
+        if (spins < kSpinCount) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::vector<Cell> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+    alignas(64) std::atomic<int> sleepers_;    // 休眠的消费者数
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cond_;
+};
+
+} // namespace opus_analyzer
@@ -0,0 +1,217 @@
+/*
+ * Opus Ogg Muxer
+ * 流式 Ogg Opus 封装实现
+ */
+
+#include "opus_ogg_muxer.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint8_t kOggHeaderContinued = 0x01;
+const uint8_t kOggHeaderBos = 0x02;
+const uint8_t kOggHeaderEos = 0x04;
+const uint32_t kDefaultPageSamples = 48000; // 1 秒
+const char kVendorString[] = "opus_analyzer";
+
+// Ogg CRC32 查找表（多项式 0x04C11DB7，不反转）
+struct OggCrcTable {
+    uint32_t entries[256];
+
+    OggCrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t r = i << 24;
+            for (int j = 0; j < 8; j++) {
+                r = (r & 0x80000000U) ? (r << 1) ^ 0x04C11DB7U : (r << 1);
+            }
+            entries[i] = r;
+        }
+    }
+};
+
+// Ogg CRC32（初值 0）；查找表是函数内静态对象，C++11 保证多线程下只初始化一次
+uint32_t oggCrcUpdate(uint32_t crc, const uint8_t* data, size_t length) {
+    static const OggCrcTable table;
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc << 8) ^ table.entries[((crc >> 24) ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+void putLE16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void putLE64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+bool writeFully(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+OggOpusMuxer::OggOpusMuxer(int fd, const OggOpusConfig& config)
+    : fd_(fd),
+      config_(config),
+      page_sequence_(0),
+      granule_(0),
+      page_samples_(0),
+      bos_written_(false),
+      finished_(false) {
+    if (config_.max_page_samples == 0) {
+        config_.max_page_samples = kDefaultPageSamples;
+    }
+}
+
+bool OggOpusMuxer::writeHeaders() {
+    // OpusHead（RFC 7845 第 5.1 节），单独一页并带 BOS 标志
+    std::vector<uint8_t> head;
+    head.insert(head.end(), "OpusHead", "OpusHead" + 8);
+    head.push_back(1);                      // 版本
+    head.push_back(config_.channels);
+    putLE16(head, config_.pre_skip);
+    putLE32(head, config_.input_sample_rate);
+    putLE16(head, 0);                       // 输出增益
+    head.push_back(0);                      // 声道映射族 0
+    if (!writePacket(head.data(), head.size(), 0) || !flush()) {
+        return false;
+    }
+
+    // OpusTags（RFC 7845 第 5.2 节）
+    std::vector<uint8_t> tags;
+    tags.insert(tags.end(), "OpusTags", "OpusTags" + 8);
+    putLE32(tags, sizeof(kVendorString) - 1);
+    tags.insert(tags.end(), kVendorString, kVendorString + sizeof(kVendorString) - 1);
+    putLE32(tags, 0);                       // 用户注释数
+    return writePacket(tags.data(), tags.size(), 0) && flush();
+}
+
+bool OggOpusMuxer::beginPacket(size_t length) {
+    if (finished_) {
+        return false;
+    }
+    // 当前页放不下这个包的分段表时，先写出当前页
+    size_t segments = length / 255 + 1;
+    if (segments > 255) {
+        return false;
+    }
+    if (lacing_.size() + segments > 255) {
+        return flush();
+    }
+    return true;
+}
+
+void OggOpusMuxer::endPacket(size_t length, uint32_t samples) {
+    size_t remaining = length;
+    while (remaining >= 255) {
+        lacing_.push_back(255);
+        remaining -= 255;
+    }
+    lacing_.push_back(static_cast<uint8_t>(remaining));
+    granule_ += samples;
+    page_samples_ += samples;
+}
+
+bool OggOpusMuxer::writePacket(const OpusPacketBuffer& packet, uint32_t samples) {
+    if (!beginPacket(packet.total_size)) {
+        return false;
+    }
+    for (size_t i = 0; i < packet.iov.size(); i++) {
+        const uint8_t* base = static_cast<const uint8_t*>(packet.iov[i].iov_base);
+        body_.insert(body_.end(), base, base + packet.iov[i].iov_len);
+    }
+    endPacket(packet.total_size, samples);
+    if (page_samples_ >= config_.max_page_samples) {
+        return flush();
+    }
+    return true;
+}
+
+bool OggOpusMuxer::writePacket(const uint8_t* data, size_t length, uint32_t samples) {
+    if (!beginPacket(length)) {
+        return false;
+    }
+    body_.insert(body_.end(), data, data + length);
+    endPacket(length, samples);
+    if (page_samples_ >= config_.max_page_samples) {
+        return flush();
+    }
+    return true;
+}
+
+bool OggOpusMuxer::flush() {
+    if (lacing_.empty()) {
+        return true;
+    }
+    uint8_t header_type = bos_written_ ? 0 : kOggHeaderBos;
+    return writePage(header_type);
+}
+
+bool OggOpusMuxer::finish() {
+    if (finished_) {
+        return true;
+    }
+    bool ok = writePage(bos_written_ ? kOggHeaderEos : (kOggHeaderBos | kOggHeaderEos));
+    finished_ = true;
+    return ok;
+}
+
+bool OggOpusMuxer::writePage(uint8_t header_type) {
+    // 本实现不产生跨页的包
+    header_type &= ~kOggHeaderContinued;
+
+    std::vector<uint8_t> page;
+    page.reserve(27 + lacing_.size());
+    page.insert(page.end(), "OggS", "OggS" + 4);
+    page.push_back(0);                      // 版本
+    page.push_back(header_type);
+    putLE64(page, granule_);
+    putLE32(page, config_.serial);
+    putLE32(page, page_sequence_);
+    putLE32(page, 0);                       // CRC 占位
+    page.push_back(static_cast<uint8_t>(lacing_.size()));
+    page.insert(page.end(), lacing_.begin(), lacing_.end());
+
+    uint32_t crc = oggCrcUpdate(0, page.data(), page.size());
+    crc = oggCrcUpdate(crc, body_.data(), body_.size());
+    page[22] = static_cast<uint8_t>(crc);
+    page[23] = static_cast<uint8_t>(crc >> 8);
+    page[24] = static_cast<uint8_t>(crc >> 16);
+    page[25] = static_cast<uint8_t>(crc >> 24);
+
+    bool ok = writeFully(fd_, page.data(), page.size()) && writeFully(fd_, body_.data(), body_.size());
+    page_sequence_++;
+    page_samples_ = 0;
+    bos_written_ = true;
+    lacing_.clear();
+    body_.clear();
+    return ok;
+}
+
+} // namespace opus_analyzer
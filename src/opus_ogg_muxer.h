@@ -0,0 +1,91 @@
+/*
+ * Opus Ogg Muxer
+ * 流式 Ogg Opus 封装（RFC 3533 / RFC 7845）
+ */
+
+#pragma once
+
+#include "opus_packet_writer.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 编码器默认的前导采样数（libopus 在 48 kHz 下的算法延迟，RFC 7845 推荐值）
+const uint16_t OGG_OPUS_DEFAULT_PRE_SKIP = 312;
+
+// Ogg Opus 流参数
+struct OggOpusConfig {
+    uint32_t serial;              // 逻辑流序列号
+    uint8_t channels;             // 声道数（1-2）
+    uint16_t pre_skip;            // 解码前需丢弃的采样数（48 kHz）
+    uint32_t input_sample_rate;   // 原始采样率（仅供参考）
+    uint32_t max_page_samples;    // 每页最多累积的采样数（48 kHz），0 为默认 1 秒
+};
+
+/**
+ * 流式 Ogg 封装器
+ * 每次写入一个 Opus 包，凑满一页后计算 CRC 并写出，内存占用不超过一页。
+ * Opus 包最多 48 帧，始终能放进单页，不需要跨页续包。
+ */
+class OggOpusMuxer {
+public:
+    /**
+     * @param fd 输出文件描述符
+     * @param config 流参数
+     */
+    OggOpusMuxer(int fd, const OggOpusConfig& config);
+
+    /**
+     * 写出 OpusHead 和 OpusTags 头部页
+     * @return 是否成功
+     */
+    bool writeHeaders();
+
+    /**
+     * 写入一个 Opus 包
+     * @param packet 组包结果
+     * @param samples 包的采样数（48 kHz）
+     * @return 是否成功
+     */
+    bool writePacket(const OpusPacketBuffer& packet, uint32_t samples);
+
+    /**
+     * 写入一个 Opus 包（连续内存）
+     * @param data 包数据
+     * @param length 包长度
+     * @param samples 包的采样数（48 kHz）
+     * @return 是否成功
+     */
+    bool writePacket(const uint8_t* data, size_t length, uint32_t samples);
+
+    /**
+     * 写出当前页
+     * @return 是否成功
+     */
+    bool flush();
+
+    /**
+     * 写出最后一页并标记流结束
+     * @return 是否成功
+     */
+    bool finish();
+
+private:
+    bool beginPacket(size_t length);
+    void endPacket(size_t length, uint32_t samples);
+    bool writePage(uint8_t header_type);
+
+    int fd_;
+    OggOpusConfig config_;
+    uint32_t page_sequence_;
+    uint64_t granule_;
+    uint32_t page_samples_;
+    bool bos_written_;
+    bool finished_;
+    std::vector<uint8_t> lacing_;
+    std::vector<uint8_t> body_;
+};
+
+} // namespace opus_analyzer
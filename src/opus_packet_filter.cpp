@@ -0,0 +1,322 @@
+/*
+ * Opus Packet Filter
+ * 包过滤实现
+ */
+
+#include "opus_packet_filter.h"
+#include "opus_frame_parser.h"
+#include "opus_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OPUS_FILTER_SSE2 1
+#endif
+
+namespace opus_analyzer {
+
+namespace {
+
+std::vector<std::string> splitString(const std::string& str, char sep) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (1) {
+        size_t pos = str.find(sep, start);
+        parts.push_back(str.substr(start, pos == std::string::npos ? std::string::npos : pos - start));
+        if (pos == std::string::npos) {
+            break;
+        }
+        start = pos + 1;
+    }
+    return parts;
+}
+
+bool parseUint(const std::string& str, uint32_t& value) {
+    if (str.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long v = strtoul(str.c_str(), &end, 10);
+    if (*end != '\0' || v > 0xFFFFFFFFUL) {
+        return false;
+    }
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+// TOC 字节的各个字段
+struct TocFields {
+    uint8_t config;
+    bool stereo;
+    uint8_t code;
+    OpusMode mode;
+    OpusBandwidth bandwidth;
+    OpusFrameSize frame_size;
+};
+
+TocFields getTocFields(uint8_t toc) {
+    TocFields f;
+    parseTOC(toc, f.config, f.stereo, f.code);
+    getConfigInfo(f.config, f.mode, f.bandwidth, f.frame_size);
+    return f;
+}
+
+// 判断 TOC 字段是否匹配单个取值
+bool matchTocValue(const std::string& key, const std::string& value, const TocFields& f, bool& valid) {
+    valid = true;
+    if (key == "mode") {
+        if (value == "silk") return f.mode == OpusMode::SILK_ONLY;
+        if (value == "hybrid") return f.mode == OpusMode::HYBRID;
+        if (value == "celt") return f.mode == OpusMode::CELT_ONLY;
+    } else if (key == "bw") {
+        if (value == "nb") return f.bandwidth == OpusBandwidth::NB;
+        if (value == "mb") return f.bandwidth == OpusBandwidth::MB;
+        if (value == "wb") return f.bandwidth == OpusBandwidth::WB;
+        if (value == "swb") return f.bandwidth == OpusBandwidth::SWB;
+        if (value == "fb") return f.bandwidth == OpusBandwidth::FB;
+    } else if (key == "fs") {
+        if (value == "2.5") return f.frame_size == OpusFrameSize::FRAME_2_5_MS;
+        if (value == "5") return f.frame_size == OpusFrameSize::FRAME_5_MS;
+        if (value == "10") return f.frame_size == OpusFrameSize::FRAME_10_MS;
+        if (value == "20") return f.frame_size == OpusFrameSize::FRAME_20_MS;
+        if (value == "40") return f.frame_size == OpusFrameSize::FRAME_40_MS;
+        if (value == "60") return f.frame_size == OpusFrameSize::FRAME_60_MS;
+    } else if (key == "code") {
+        uint32_t code = 0;
+        if (parseUint(value, code) && code <= 3) return f.code == code;
+    } else if (key == "config") {
+        // N 或 A-B
+        std::vector<std::string> range = splitString(value, '-');
+        uint32_t lo = 0;
+        uint32_t hi = 0;
+        if (range.size() == 1 && parseUint(range[0], lo) && lo <= 31) {
+            return f.config == lo;
+        }
+        if (range.size() == 2 && parseUint(range[0], lo) && parseUint(range[1], hi) && lo <= hi && hi <= 31) {
+            return f.config >= lo && f.config <= hi;
+        }
+    }
+    valid = false;
+    return false;
+}
+
+// 编译 TOC 相关条件：在查找表中清除不匹配的 TOC
+bool compileTocTerm(const std::string& key, const std::string& values, OpusPacketFilter& filter) {
+    std::vector<std::string> options = splitString(values, '|');
+    for (int toc = 0; toc < 256; toc++) {
+        TocFields f = getTocFields(static_cast<uint8_t>(toc));
+        bool any = false;
+        for (size_t i = 0; i < options.size(); i++) {
+            bool valid = false;
+            if (matchTocValue(key, options[i], f, valid)) {
+                any = true;
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        if (!any) {
+            filter.toc_table[toc] = 0;
+        }
+    }
+    return true;
+}
+
+// 编译数值比较条件（size、frames）
+bool compileRangeTerm(const std::string& term, const std::string& key, uint32_t& lo, uint32_t& hi) {
+    std::string rest = term.substr(key.size());
+    std::string op;
+    while (!rest.empty() && (rest[0] == '<' || rest[0] == '>' || rest[0] == '=')) {
+        op += rest[0];
+        rest = rest.substr(1);
+    }
+    uint32_t n = 0;
+    if (!parseUint(rest, n)) {
+        return false;
+    }
+    if (op == "<") {
+        if (n == 0) {
+            // 空区间
+            lo = 1;
+            hi = 0;
+        } else if (n - 1 < hi) {
+            hi = n - 1;
+        }
+    } else if (op == "<=") {
+        if (n < hi) hi = n;
+    } else if (op == ">") {
+        if (n == 0xFFFFFFFFU) {
+            lo = 1;
+            hi = 0;
+        } else if (n + 1 > lo) {
+            lo = n + 1;
+        }
+    } else if (op == ">=") {
+        if (n > lo) lo = n;
+    } else if (op == "=") {
+        if (n > lo) lo = n;
+        if (n < hi) hi = n;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+uint8_t getPacketFlags(const OpusFrameInfo& frame_info) {
+    uint8_t flags = 0;
+    if (frame_info.has_padding) flags |= OPUS_PACKET_FLAG_PADDING;
+    if (frame_info.is_self_delimiting) flags |= OPUS_PACKET_FLAG_SELF_DELIMITING;
+    if (frame_info.frame_count_code == 3 && frame_info.is_cbr) flags |= OPUS_PACKET_FLAG_CBR;
+    return flags;
+}
+
+} // namespace
+
+void OpusPacketColumns::clear() {
+    toc.clear();
+    flags.clear();
+    total_size.clear();
+    frame_count.clear();
+}
+
+void OpusPacketColumns::append(const OpusFrameInfo& frame_info) {
+    toc.push_back(frame_info.toc_byte);
+    flags.push_back(getPacketFlags(frame_info));
+    total_size.push_back(getPacketSize(frame_info));
+    frame_count.push_back(frame_info.frame_count);
+}
+
+bool compilePacketFilter(const std::string& expr, OpusPacketFilter& filter) {
+    memset(filter.toc_table, 1, sizeof(filter.toc_table));
+    filter.flags_mask = 0;
+    filter.flags_value = 0;
+    filter.size_min = 0;
+    filter.size_max = 0xFFFFFFFFU;
+    filter.frames_min = 0;
+    filter.frames_max = 0xFFFFFFFFU;
+
+    std::vector<std::string> terms = splitString(expr, ',');
+    for (size_t i = 0; i < terms.size(); i++) {
+        const std::string& term = terms[i];
+        size_t eq = term.find('=');
+        std::string key = eq == std::string::npos ? term : term.substr(0, eq);
+
+        if (term.compare(0, 6, "frames") == 0) {
+            if (!compileRangeTerm(term, "frames", filter.frames_min, filter.frames_max)) {
+                return false;
+            }
+        } else if (term.compare(0, 4, "size") == 0) {
+            if (!compileRangeTerm(term, "size", filter.size_min, filter.size_max)) {
+                return false;
+            }
+        } else if (eq != std::string::npos) {
+            if (!compileTocTerm(key, term.substr(eq + 1), filter)) {
+                return false;
+            }
+        } else if (term == "stereo" || term == "mono") {
+            for (int toc = 0; toc < 256; toc++) {
+                bool stereo = ((toc >> 2) & 0x01) != 0;
+                if (stereo != (term == "stereo")) {
+                    filter.toc_table[toc] = 0;
+                }
+            }
+        } else if (term == "padding") {
+            filter.flags_mask |= OPUS_PACKET_FLAG_PADDING;
+            filter.flags_value |= OPUS_PACKET_FLAG_PADDING;
+        } else if (term == "sd") {
+            filter.flags_mask |= OPUS_PACKET_FLAG_SELF_DELIMITING;
+            filter.flags_value |= OPUS_PACKET_FLAG_SELF_DELIMITING;
+        } else if (term == "cbr" || term == "vbr") {
+            // 仅 3 号包区分 CBR/VBR
+            compileTocTerm("code", "3", filter);
+            filter.flags_mask |= OPUS_PACKET_FLAG_CBR;
+            if (term == "cbr") {
+                filter.flags_value |= OPUS_PACKET_FLAG_CBR;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool matchPacket(const OpusPacketFilter& filter, const OpusFrameInfo& frame_info) {
+    // 3 号 VBR 包的 total_size 为 0，需按各帧长度计算
+    uint32_t size = getPacketSize(frame_info);
+    return filter.toc_table[frame_info.toc_byte] != 0 &&
+           (getPacketFlags(frame_info) & filter.flags_mask) == filter.flags_value &&
+           size >= filter.size_min && size <= filter.size_max &&
+           frame_info.frame_count >= filter.frames_min && frame_info.frame_count <= filter.frames_max;
+}
+
+size_t filterPackets(const OpusPacketFilter& filter, const OpusPacketColumns& columns,
+                     std::vector<uint8_t>& selected) {
+    size_t n = columns.size();
+    selected.resize(n);
+    uint8_t* sel = selected.data();
+    size_t i = 0;
+
+    // 标志位：(flags & mask) == value
+#ifdef OPUS_FILTER_SSE2
+    const __m128i one8 = _mm_set1_epi8(1);
+    const __m128i mask8 = _mm_set1_epi8(static_cast<char>(filter.flags_mask));
+    const __m128i value8 = _mm_set1_epi8(static_cast<char>(filter.flags_value));
+    for (; i + 16 <= n; i += 16) {
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&columns.flags[i]));
+        __m128i eq = _mm_cmpeq_epi8(_mm_and_si128(f, mask8), value8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sel + i), _mm_and_si128(eq, one8));
+    }
+#endif
+    for (; i < n; i++) {
+        sel[i] = (columns.flags[i] & filter.flags_mask) == filter.flags_value;
+    }
+
+    // TOC：查表
+    for (i = 0; i < n; i++) {
+        sel[i] &= filter.toc_table[columns.toc[i]];
+    }
+
+    // 数值区间：只检查被约束的列
+    const uint32_t* ranges[2] = {columns.total_size.data(), columns.frame_count.data()};
+    const uint32_t mins[2] = {filter.size_min, filter.frames_min};
+    const uint32_t maxs[2] = {filter.size_max, filter.frames_max};
+    for (int c = 0; c < 2; c++) {
+        if (mins[c] == 0 && maxs[c] == 0xFFFFFFFFU) {
+            continue;
+        }
+        const uint32_t* col = ranges[c];
+        i = 0;
+#ifdef OPUS_FILTER_SSE2
+        // SSE2 只有有符号比较：先翻转符号位
+        const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000U));
+        const __m128i lo = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(mins[c])), bias);
+        const __m128i hi = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(maxs[c])), bias);
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i)), bias);
+            __m128i out = _mm_or_si128(_mm_cmplt_epi32(v, lo), _mm_cmpgt_epi32(v, hi));
+            int bits = _mm_movemask_ps(_mm_castsi128_ps(out));
+            if (bits != 0) {
+                for (int k = 0; k < 4; k++) {
+                    if (bits & (1 << k)) {
+                        sel[i + k] = 0;
+                    }
+                }
+            }
+        }
+#endif
+        for (; i < n; i++) {
+            if (col[i] < mins[c] || col[i] > maxs[c]) {
+                sel[i] = 0;
+            }
+        }
+    }
+
+    size_t count = 0;
+    for (i = 0; i < n; i++) {
+        count += sel[i];
+    }
+    return count;
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,77 @@
+/*
+ * Opus Packet Filter
+ * 包过滤：将过滤表达式编译为 TOC 查找表、标志掩码和数值区间，按列批量求值
+ */
+
+#pragma once
+
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 包标志位（OpusPacketColumns::flags）
+const uint8_t OPUS_PACKET_FLAG_PADDING = 0x01;         // 有填充字节
+const uint8_t OPUS_PACKET_FLAG_SELF_DELIMITING = 0x02; // 带分界包
+const uint8_t OPUS_PACKET_FLAG_CBR = 0x04;             // 3 号包 CBR
+
+// 一批包的列式存储（每列一个数组，下标相同的元素属于同一个包）
+struct OpusPacketColumns {
+    std::vector<uint8_t> toc;           // TOC 字节
+    std::vector<uint8_t> flags;         // 标志位
+    std::vector<uint32_t> total_size;   // 包大小（3 号 VBR 包按各帧长度计算）
+    std::vector<uint32_t> frame_count;  // 帧数
+
+    void clear();
+    void append(const OpusFrameInfo& frame_info);
+    size_t size() const { return toc.size(); }
+};
+
+// 编译后的过滤条件：所有条件同时满足才选中
+struct OpusPacketFilter {
+    uint8_t toc_table[256];       // 按 TOC 字节查表（config、立体声、帧数代码相关条件）
+    uint8_t flags_mask;           // 需要检查的标志位
+    uint8_t flags_value;          // 标志位的期望值
+    uint32_t size_min;            // 包大小区间（闭区间）
+    uint32_t size_max;
+    uint32_t frames_min;          // 帧数区间（闭区间）
+    uint32_t frames_max;
+};
+
+/**
+ * 编译过滤表达式
+ * 表达式为逗号分隔的条件，例如 "mode=celt,bw=fb,stereo,size>200"、"code=3,padding"。
+ * 支持的条件：
+ *   mode=silk|hybrid|celt   bw=nb|mb|wb|swb|fb   fs=2.5|5|10|20|40|60
+ *   config=N 或 config=A-B   code=0|1|2|3   stereo   mono
+ *   padding   sd   cbr   vbr
+ *   size<N size<=N size>N size>=N size=N（frames 同理）
+ * 同一条件中可用 | 列出多个取值。
+ * @param expr 过滤表达式
+ * @param filter 输出：编译结果
+ * @return 表达式是否有效
+ */
+bool compilePacketFilter(const std::string& expr, OpusPacketFilter& filter);
+
+/**
+ * 判断单个包是否满足过滤条件
+ * @param filter 编译后的过滤条件
+ * @param frame_info parseOpusPacket 的解析结果
+ * @return 是否选中
+ */
+bool matchPacket(const OpusPacketFilter& filter, const OpusFrameInfo& frame_info);
+
+/**
+ * 对一批包求值过滤条件（SSE2 可用时按向量处理）
+ * @param filter 编译后的过滤条件
+ * @param columns 包的列式存储
+ * @param selected 输出：每个包是否选中（0 或 1）
+ * @return 选中的包数
+ */
+size_t filterPackets(const OpusPacketFilter& filter, const OpusPacketColumns& columns,
+                     std::vector<uint8_t>& selected);
+
+} // namespace opus_analyzer
@@ -0,0 +1,187 @@
+/*
+ * Opus Packet Stream
+ * 滑动窗口与包流实现
+ */
+
+#include "opus_packet_stream.h"
+#include "opus_trace.h"
+#include <string.h>
+
+namespace opus_analyzer {
+
+OpusStreamWindow::OpusStreamWindow(size_t window_size)
+    : window_size_(window_size), file_(nullptr), feeding_(false),
+      data_(nullptr), size_(0), base_(0), eof_(true) {
+}
+
+OpusStreamWindow::~OpusStreamWindow() {
+    close();
+}
+
+void OpusStreamWindow::close() {
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    feeding_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    base_ = 0;
+    eof_ = true;
+}
+
+bool OpusStreamWindow::openFile(const char* path, uint64_t offset) {
+    close();
+    {
+        OPUS_TRACE_SCOPE("open");
+        file_ = fopen(path, "rb");
+    }
+    if (file_ == nullptr) {
+        return false;
+    }
+    if (fseeko(file_, static_cast<off_t>(offset), SEEK_SET) != 0) {
+        close();
+        return false;
+    }
+    buffer_.resize(window_size_);
+    data_ = buffer_.data();
+    base_ = offset;
+    eof_ = false;
+    return advance(offset);
+}
+
+void OpusStreamWindow::attachBuffer(const uint8_t* data, size_t length, uint64_t offset) {
+    close();
+    if (offset > length) {
+        offset = length;
+    }
+    data_ = data + offset;
+    size_ = static_cast<size_t>(length - offset);
+    base_ = offset;
+}
+
+void OpusStreamWindow::openFeed() {
+    close();
+    buffer_.clear();
+    feeding_ = true;
+    eof_ = false;
+}
+
+void OpusStreamWindow::feed(const uint8_t* data, size_t length) {
+    if (!feeding_ || eof_ || length == 0) {
+        return;
+    }
+    buffer_.insert(buffer_.end(), data, data + length);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+void OpusStreamWindow::finishFeed() {
+    eof_ = true;
+}
+
+bool OpusStreamWindow::advance(uint64_t offset) {
+    if ((file_ == nullptr && !feeding_) || eof_) {
+        return true;
+    }
+
+    // 丢弃 offset 之前的数据（包边界只向后查找，不需要回看）
+    size_t shift = static_cast<size_t>(offset - base_);
+    if (shift > 0) {
+        memmove(&buffer_[0], &buffer_[shift], size_ - shift);
+        size_ -= shift;
+        base_ = offset;
+    }
+    if (feeding_) {
+        buffer_.resize(size_);
+        data_ = buffer_.data();
+        return true;
+    }
+
+    OPUS_TRACE_SCOPE("read");
+    while (size_ < buffer_.size()) {
+        size_t rsz = fread(&buffer_[size_], 1, buffer_.size() - size_, file_);
+        size_ += rsz;
+        if (rsz == 0) {
+            if (ferror(file_)) {
+                return false;
+            }
+            eof_ = true;
+            break;
+        }
+    }
+    return true;
+}
+
+OpusPacketStream::OpusPacketStream()
+    : window_(OPUS_STREAM_READ_SIZE + OPUS_STREAM_GUARD_SIZE),
+      position_(0), error_(false) {
+}
+
+bool OpusPacketStream::open(const char* path, uint64_t offset) {
+    position_ = offset;
+    sync_.reset();
+    error_ = false;
+    return window_.openFile(path, offset);
+}
+
+void OpusPacketStream::attach(const uint8_t* data, size_t length, uint64_t offset) {
+    window_.attachBuffer(data, length, offset);
+    position_ = window_.base();
+    sync_.reset();
+    error_ = false;
+}
+
+void OpusPacketStream::openFeed() {
+    window_.openFeed();
+    position_ = 0;
+    sync_.reset();
+    error_ = false;
+}
+
+void OpusPacketStream::feed(const uint8_t* data, size_t length) {
+    window_.feed(data, length);
+}
+
+void OpusPacketStream::finish() {
+    window_.finishFeed();
+}
+
+bool OpusPacketStream::next(OpusStreamPacket& packet) {
+    while (1) {
+        size_t pos = static_cast<size_t>(position_ - window_.base());
+        size_t avail = window_.size() - pos;
+        if (!window_.eof() && avail < OPUS_STREAM_GUARD_SIZE) {
+            uint64_t end = window_.base() + window_.size();
+            if (!window_.advance(position_)) {
+                error_ = true;
+                return false;
+            }
+            if (!window_.eof() && window_.base() + window_.size() == end) {
+                return false; // 送入的数据不够，等待更多数据
+            }
+            continue;
+        }
+        if (avail == 0) {
+            return false;
+        }
+
+        // 不可信的位置：跳到打分确认的下一个包边界，没有找到时跳到需要读入数据的位置，读入后继续查找
+        size_t limit = window_.eof() ? window_.size() : window_.size() - OPUS_STREAM_GUARD_SIZE;
+        size_t next = 0;
+        uint32_t size = sync_.parse(window_.data(), window_.size(), pos, limit, window_.base(),
+                                    packet.frame_info, next);
+        if (size == 0) {
+            position_ += next - pos;
+            continue;
+        }
+
+        packet.offset = position_;
+        packet.data = window_.data() + pos;
+        packet.size = size;
+        position_ += size;
+        return true;
+    }
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,156 @@
+/*
+ * Opus Packet Stream
+ * 按滑动窗口读取 Opus 裸流并逐个返回包，偏移为 64 位绝对位置，内存占用与文件大小无关
+ */
+
+#pragma once
+
+#include "opus_packet_sync.h"
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+/**
+ * 滑动窗口
+ * 缓冲区大小固定为 window_size：前进时丢弃当前位置之前的数据，之后至少有 window_size 字节（文件末尾除外）。也可以直接挂接内存中的整个流（例如 mmap 映射的文件），
+ * 或者由调用方逐段送入数据（此时缓冲区大小取决于调用方送入而尚未解析的数据量）。
+ */
+class OpusStreamWindow {
+public:
+    /**
+     * @param window_size 当前位置之后保证可用的字节数
+     */
+    explicit OpusStreamWindow(size_t window_size);
+    ~OpusStreamWindow();
+
+    /**
+     * 打开文件，从 offset 处开始读取
+     * @return 是否成功
+     */
+    bool openFile(const char* path, uint64_t offset);
+
+    /**
+     * 挂接内存中的流（不复制），窗口从 offset 处开始
+     * @param data 流数据（从流的开头开始）
+     * @param length 数据长度
+     * @param offset 起始位置
+     */
+    void attachBuffer(const uint8_t* data, size_t length, uint64_t offset);
+
+    /**
+     * 开始接收调用方送入的数据（流从偏移 0 开始）
+     */
+    void openFeed();
+
+    /**
+     * 追加数据（复制到内部缓冲区）
+     * @param data 数据
+     * @param length 数据长度
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * 标记数据已全部送入
+     */
+    void finishFeed();
+
+    /**
+     * 将窗口前移到 offset（丢弃 offset 之前的数据）并读入更多数据
+     * @param offset 新的当前位置，不能早于 base()
+     * @return 是否成功（读取出错时返回 false）
+     */
+    bool advance(uint64_t offset);
+
+    const uint8_t* data() const { return data_; }   // 窗口数据，data()[0] 位于 base() 处
+    size_t size() const { return size_; }           // 窗口内的字节数
+    uint64_t base() const { return base_; }         // 窗口起点的绝对偏移
+    bool eof() const { return eof_; }               // 之后没有更多数据
+
+private:
+    OpusStreamWindow(const OpusStreamWindow&);
+    OpusStreamWindow& operator=(const OpusStreamWindow&);
+
+    void close();
+
+    size_t window_size_;
+    FILE* file_;
+    bool feeding_;                // 数据由调用方送入
+    std::vector<uint8_t> buffer_;
+    const uint8_t* data_;
+    size_t size_;
+    uint64_t base_;
+    bool eof_;
+};
+
+// 包流的窗口参数
+const size_t OPUS_STREAM_READ_SIZE = 1024 * 1024;     // 每次至少读入的字节数
+const size_t OPUS_STREAM_GUARD_SIZE = 128 * 1024;     // 大于最大包长
+
+// 流中的一个包
+struct OpusStreamPacket {
+    uint64_t offset;              // 包在流中的绝对偏移
+    const uint8_t* data;          // 包数据（下一次调用 next 或 feed 之前有效）
+    uint32_t size;                // 包长度
+    OpusFrameInfo frame_info;
+};
+
+/**
+ * 包流
+ * 在滑动窗口上逐个解析包；失去同步时按 OpusPacketSync 的打分查找新的包边界，跳过的字节按区间记录。
+ * 起始于窗口末尾 OPUS_STREAM_GUARD_SIZE 字节内的包等读入更多数据后再解析，使任何位置的包都能完整读到。
+ */
+class OpusPacketStream {
+public:
+    OpusPacketStream();
+
+    /**
+     * 打开文件，从 offset 处开始解析（offset 应为包边界，例如分析检查点）
+     * @return 是否成功
+     */
+    bool open(const char* path, uint64_t offset = 0);
+
+    /**
+     * 解析内存中的流，从 offset 处开始
+     */
+    void attach(const uint8_t* data, size_t length, uint64_t offset = 0);
+
+    /**
+     * 开始接收调用方逐段送入的数据，之后用 feed 追加，全部送入后调用 finish
+     */
+    void openFeed();
+
+    /**
+     * 追加数据
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * 标记数据已全部送入，之后 next 会解析到数据末尾
+     */
+    void finish();
+
+    /**
+     * 取下一个包
+     * @param packet 输出：包
+     * @return 是否取到（流结束、需要送入更多数据或读取出错时返回 false，用 needsData/hasError 区分）
+     */
+    bool next(OpusStreamPacket& packet);
+
+    uint64_t position() const { return position_; }       // 下一次解析的位置
+    uint64_t skippedBytes() const { return sync_.skippedBytes(); }   // 到当前位置为止跳过的字节数
+    const OpusPacketSync& sync() const { return sync_; }              // 跳过的区间
+    bool hasError() const { return error_; }
+    bool needsData() const { return !error_ && !window_.eof(); } // next 返回 false 后：等待送入更多数据
+
+private:
+    OpusStreamWindow window_;
+    OpusPacketSync sync_;
+    uint64_t position_;
+    bool error_;
+};
+
+} // namespace opus_analyzer
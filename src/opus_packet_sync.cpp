@@ -0,0 +1,225 @@
+/*
+ * Opus Packet Sync
+ * 包边界同步实现
+ */
+
+#include "opus_packet_sync.h"
+#include "opus_frame_parser.h"
+#include "opus_trace.h"
+#include "opus_utils.h"
+#include <utility>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint32_t kMaxFrameSize = 1275;
+const uint32_t kMaxPacketSamples = 5760;   // 120 ms
+
+// 只看 TOC 和帧数字节的快速检查：3 号包超过 120 ms 时不必再解析
+// （3 号 CBR 包在数据很长时会向后搜索包边界，在垃圾数据上代价很高）
+bool checkPacketHeader(const uint8_t* data, size_t length) {
+    if ((data[0] & 0x03) != 3) {
+        return true;
+    }
+    if (length < 2) {
+        return false;
+    }
+    OpusMode mode;
+    OpusBandwidth bandwidth;
+    OpusFrameSize frame_size;
+    if (!getConfigInfo(data[0] >> 3, mode, bandwidth, frame_size)) {
+        return false;
+    }
+    uint32_t frame_count = data[1] & 0x3F;
+    return frame_count > 0 && getFrameSamples(frame_size) * frame_count <= kMaxPacketSamples;
+}
+
+// 解析一个包，返回包长度（无法解析、数据不完整或不合理时返回 0）
+uint32_t parsePlausiblePacket(const uint8_t* data, size_t length, size_t pos, OpusFrameInfo& frame_info) {
+    if (pos >= length || !checkPacketHeader(data + pos, length - pos) ||
+        !parseOpusPacket(data + pos, length - pos, frame_info)) {
+        return 0;
+    }
+    uint32_t packet_size = getPacketSize(frame_info);
+    if (packet_size > length - pos || !isPlausiblePacket(frame_info, packet_size)) {
+        return 0;
+    }
+    return packet_size;
+}
+
+// 配置数和声道位（TOC 的高 6 位）
+uint8_t getTocConfig(uint8_t toc) {
+    return toc >> 2;
+}
+
+// 相邻两个包的得分：配置数和声道数相同 3 分，帧长度和声道数相同 2 分
+int scoreTocLink(uint8_t prev_toc, uint8_t toc) {
+    if (getTocConfig(prev_toc) == getTocConfig(toc)) {
+        return 3;
+    }
+    OpusMode mode;
+    OpusBandwidth bandwidth;
+    OpusFrameSize prev_frame_size;
+    OpusFrameSize frame_size;
+    if ((prev_toc & 0x04) != (toc & 0x04) || !getConfigInfo(prev_toc >> 3, mode, bandwidth, prev_frame_size) ||
+        !getConfigInfo(toc >> 3, mode, bandwidth, frame_size)) {
+        return 0;
+    }
+    return prev_frame_size == frame_size ? 2 : 0;
+}
+
+} // namespace
+
+bool isPlausiblePacket(const OpusFrameInfo& frame_info, uint32_t packet_size) {
+    if (packet_size == 0 || frame_info.frame_count == 0) {
+        return false;
+    }
+    if (getFrameSamples(frame_info.frame_size) * frame_info.frame_count > kMaxPacketSamples) {
+        return false;
+    }
+    for (size_t i = 0; i < frame_info.frame_sizes.size(); i++) {
+        if (frame_info.frame_sizes[i] > kMaxFrameSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int scorePacketBoundary(const uint8_t* data, size_t length, size_t candidate, bool at_end) {
+    if (data == nullptr) {
+        return -1;
+    }
+    OpusFrameInfo frame_info;
+    uint32_t packet_size = parsePlausiblePacket(data, length, candidate, frame_info);
+    if (packet_size == 0) {
+        return -1;
+    }
+
+    const int followers = OPUS_SYNC_CHAIN_LENGTH - 1;
+    size_t prev = candidate;
+    size_t offset = candidate + packet_size;
+    int score = 0;
+    int checked = 0;
+    while (checked < followers) {
+        if (offset == length) {
+            if (!at_end) {
+                break; // 后面的数据还没有读入，无法判断
+            }
+            // 包链正好结束于流的末尾：按已检查的包折算
+            return checked == 0 ? OPUS_SYNC_THRESHOLD : score * followers / checked;
+        }
+        // 先只按 TOC 计分，之后的包全部满分也达不到阈值时不必再解析
+        int link = scoreTocLink(data[prev], data[offset]);
+        if (score + link + 3 * (followers - checked - 1) < OPUS_SYNC_THRESHOLD) {
+            break;
+        }
+        OpusFrameInfo next_info;
+        packet_size = parsePlausiblePacket(data, length, offset, next_info);
+        if (packet_size == 0) {
+            break;
+        }
+        score += link;
+        prev = offset;
+        offset += packet_size;
+        checked++;
+    }
+    return score;
+}
+
+bool findSyncPoint(const uint8_t* data, size_t length, size_t start, size_t limit, size_t& boundary) {
+    if (data == nullptr) {
+        return false;
+    }
+    bool at_end = limit >= length;
+    if (limit > length) {
+        limit = length;
+    }
+    for (size_t candidate = start; candidate < limit; candidate++) {
+        // 从包中间开始的假包常常正好结束于真正的包边界，之后的包链都是真的，得分也够；
+        // 因此盲目查找时还要求候选包与下一个包的配置数和声道数相同（先检查这一条，多数位置只需解析一次）
+        OpusFrameInfo frame_info;
+        uint32_t packet_size = parsePlausiblePacket(data, length, candidate, frame_info);
+        if (packet_size == 0) {
+            continue;
+        }
+        size_t end = candidate + packet_size;
+        if (end == length ? !at_end : getTocConfig(data[end]) != getTocConfig(data[candidate])) {
+            continue;
+        }
+        if (scorePacketBoundary(data, length, candidate, at_end) >= OPUS_SYNC_THRESHOLD) {
+            boundary = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+OpusPacketSync::OpusPacketSync() {
+    reset();
+}
+
+void OpusPacketSync::reset() {
+    locked_ = false;
+    last_toc_ = 0;
+    skipped_bytes_ = 0;
+    range_count_ = 0;
+    range_end_ = 0;
+    ranges_.clear();
+}
+
+uint32_t OpusPacketSync::parse(const uint8_t* data, size_t length, size_t pos, size_t limit, uint64_t base,
+                               OpusFrameInfo& frame_info, size_t& next) {
+    bool at_end = limit >= length;
+    if (limit > length) {
+        limit = length;
+    }
+    // 解析到局部变量再移动给调用方，parseOpusPacket 会清零整个结构体
+    OpusFrameInfo parsed;
+    uint32_t packet_size = parsePlausiblePacket(data, length, pos, parsed);
+    if (packet_size > 0 && (!locked_ || getTocConfig(parsed.toc_byte) != last_toc_) &&
+        scorePacketBoundary(data, length, pos, at_end) < OPUS_SYNC_THRESHOLD) {
+        packet_size = 0;
+    }
+    if (packet_size > 0) {
+        locked_ = true;
+        last_toc_ = getTocConfig(parsed.toc_byte);
+        frame_info = std::move(parsed);
+        return packet_size;
+    }
+
+    // 失去同步：查找得分足够的下一个位置
+    OPUS_TRACE_SCOPE("resync");
+    size_t boundary = 0;
+    if (findSyncPoint(data, length, pos + 1, limit, boundary)) {
+        next = boundary;
+        locked_ = true;
+        last_toc_ = getTocConfig(data[boundary]);
+    } else {
+        next = limit > pos + 1 ? limit : pos + 1;
+        locked_ = false;
+    }
+    skip(base + pos, next - pos);
+    return 0;
+}
+
+void OpusPacketSync::skip(uint64_t offset, uint64_t length) {
+    skipped_bytes_ += length;
+    if (range_count_ > 0 && offset == range_end_) {
+        // 与上一个区间相邻，合并
+        if (ranges_.size() == range_count_) {
+            ranges_.back().length += length;
+        }
+    } else {
+        range_count_++;
+        if (ranges_.size() < OPUS_SYNC_MAX_RANGES) {
+            OpusByteRange range;
+            range.offset = offset;
+            range.length = length;
+            ranges_.push_back(range);
+        }
+    }
+    range_end_ = offset + length;
+}
+
+} // namespace opus_analyzer
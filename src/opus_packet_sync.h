@@ -0,0 +1,106 @@
+/*
+ * Opus Packet Sync
+ * 包边界同步：给候选位置打分，只在得分足够时锁定包边界，并记录跳过的字节区间
+ */
+
+#pragma once
+
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 跳过的字节区间 [offset, offset + length)
+struct OpusByteRange {
+    uint64_t offset;              // 区间起始的绝对偏移
+    uint64_t length;              // 字节数
+};
+
+// 打分参数
+const int OPUS_SYNC_CHAIN_LENGTH = 6;      // 打分时检查的连续包数（含候选位置的包）
+const int OPUS_SYNC_THRESHOLD = 10;        // 后续 5 个包满分 15；10 分相当于每个包都与前一个包同属一个配置族
+const size_t OPUS_SYNC_MAX_RANGES = 1024;  // 最多记录的跳过区间数（之后只计数）
+
+/**
+ * 检查包的大小和时长是否合理
+ * 每帧不超过 1275 字节，整个包不超过 120 ms。
+ * @param frame_info parseOpusPacket 的解析结果
+ * @param packet_size 包大小
+ * @return 是否合理
+ */
+bool isPlausiblePacket(const OpusFrameInfo& frame_info, uint32_t packet_size);
+
+/**
+ * 给候选包边界打分
+ * 从候选位置开始最多解析 OPUS_SYNC_CHAIN_LENGTH 个连续的包。之后的每个包与前一个包配置数和声道数都相同得 3 分，
+ * 只是帧长度和声道数相同（同一配置族，例如 SILK 与 CELT 之间切换）得 2 分，否则不得分；
+ * 遇到无法解析或大小、时长不合理的包即停止。
+ * 包链正好结束于流的末尾时按已检查的包数折算满分；只有一个包到末尾时无从检查，直接返回阈值。
+ * 数据末尾不是流的末尾时，包链到达数据末尾即停止（不完整的包可能被当成吞掉剩余数据的包）。
+ * @param data 数据缓冲区
+ * @param length 数据长度
+ * @param candidate 候选位置
+ * @param at_end data + length 是否为流的末尾
+ * @return 得分，候选位置本身不是合理的包时返回 -1
+ */
+int scorePacketBoundary(const uint8_t* data, size_t length, size_t candidate, bool at_end);
+
+/**
+ * 查找得分达到 OPUS_SYNC_THRESHOLD、且与下一个包配置数和声道数相同的第一个位置
+ * @param data 数据缓冲区
+ * @param length 数据长度
+ * @param start 开始查找的位置
+ * @param limit 只查找 limit 之前的位置（limit 不小于 length 时 length 即流的末尾）
+ * @param boundary 输出：包边界位置
+ * @return 是否找到
+ */
+bool findSyncPoint(const uint8_t* data, size_t length, size_t start, size_t limit, size_t& boundary);
+
+/**
+ * 包边界同步状态
+ * 锁定后按包长度逐个前进，只有配置数或声道数变化、包不合理时才重新打分；
+ * 失去同步后按分数查找新的包边界，不会锁定到第一个恰好能解析的位置。
+ */
+class OpusPacketSync {
+public:
+    OpusPacketSync();
+
+    /**
+     * 清空状态和跳过区间（下一个包需要重新打分确认）
+     */
+    void reset();
+
+    /**
+     * 解析 pos 处的包
+     * 不是可信的包边界时向后查找新的包边界，把跳过的字节记为一个区间，由调用方从 next 处继续。
+     * @param data 数据缓冲区
+     * @param length 可用数据长度
+     * @param pos 当前位置
+     * @param limit 查找新包边界的上限（之后起始的包可能不完整），没有找到时 next 为 limit（至少前进 1 字节）；
+     *              不小于 length 时 length 即流的末尾
+     * @param base data[0] 的绝对偏移
+     * @param frame_info 输出：包信息
+     * @param next 输出：返回 0 时下一个要解析的位置
+     * @return 包大小，pos 处不是可信的包时返回 0
+     */
+    uint32_t parse(const uint8_t* data, size_t length, size_t pos, size_t limit, uint64_t base,
+                   OpusFrameInfo& frame_info, size_t& next);
+
+    uint64_t skippedBytes() const { return skipped_bytes_; }    // 跳过的字节数
+    uint64_t skippedRangeCount() const { return range_count_; } // 跳过的区间数（相邻的区间合并计算）
+    const std::vector<OpusByteRange>& skippedRanges() const { return ranges_; } // 前 OPUS_SYNC_MAX_RANGES 个区间
+
+private:
+    void skip(uint64_t offset, uint64_t length);
+
+    bool locked_;                 // 当前位置是可信的包边界
+    uint8_t last_toc_;            // 上一个包 TOC 的配置数和声道位
+    uint64_t skipped_bytes_;
+    uint64_t range_count_;
+    uint64_t range_end_;          // 最后一个区间的结束位置
+    std::vector<OpusByteRange> ranges_;
+};
+
+} // namespace opus_analyzer
@@ -0,0 +1,251 @@
+/*
+ * Opus Packet Writer
+ * Opus 包写入实现（包结构参考 RFC 6716 第 3.2 节及附录 B）
+ */
+
+#include "opus_packet_writer.h"
+#include "opus_frame_header.h"
+#include "opus_utils.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint32_t kMaxFrameSize = 1275;
+const size_t kMaxFrameCount = 48;
+const uint32_t kMaxPacketSamples = 5760; // 120 ms
+
+// 填充字节来源（填充内容全为 0）
+const uint8_t kZeroPadding[4096] = {0};
+
+bool appendFrameSize(uint32_t frame_size, std::vector<uint8_t>& out) {
+    uint8_t buf[2];
+    size_t n = encodeFrameSizeEncoding(frame_size, buf);
+    if (n == 0) {
+        return false;
+    }
+    out.insert(out.end(), buf, buf + n);
+    return true;
+}
+
+void appendIov(std::vector<struct iovec>& iov, const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    struct iovec v;
+    v.iov_base = const_cast<uint8_t*>(data);
+    v.iov_len = length;
+    iov.push_back(v);
+}
+
+} // namespace
+
+size_t encodeFrameSizeEncoding(uint32_t frame_size, uint8_t* out) {
+    if (out == nullptr || frame_size > kMaxFrameSize) {
+        return 0;
+    }
+    // 0 ~ 251：单字节
+    if (frame_size < 252) {
+        out[0] = static_cast<uint8_t>(frame_size);
+        return 1;
+    }
+    // 252 ~ 1275：第一字节 252 + (size & 3)，第二字节 (size - 第一字节) / 4
+    out[0] = static_cast<uint8_t>(252 + (frame_size & 0x03));
+    out[1] = static_cast<uint8_t>((frame_size - out[0]) >> 2);
+    return 2;
+}
+
+size_t encodePaddingLength(uint32_t padding_size, std::vector<uint8_t>& out) {
+    // 每个 0xFF 表示 254 个填充字节，最后一个字节 < 0xFF 表示剩余字节数
+    size_t written = 0;
+    while (padding_size >= 254) {
+        out.push_back(0xFF);
+        padding_size -= 254;
+        written++;
+    }
+    out.push_back(static_cast<uint8_t>(padding_size));
+    return written + 1;
+}
+
+bool buildOpusPacket(uint8_t toc, const std::vector<OpusFrameSpan>& frames,
+                     const OpusPacketOptions& options, OpusPacketBuffer& packet) {
+    packet.header.clear();
+    packet.iov.clear();
+    packet.total_size = 0;
+
+    size_t count = frames.size();
+    if (count == 0 || count > kMaxFrameCount) {
+        return false;
+    }
+    bool cbr = true;
+    size_t payload_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (frames[i].length > kMaxFrameSize || (frames[i].data == nullptr && frames[i].length > 0)) {
+            return false;
+        }
+        if (frames[i].length != frames[0].length) {
+            cbr = false;
+        }
+        payload_size += frames[i].length;
+    }
+
+    toc &= 0xFC;
+    std::vector<uint8_t>& header = packet.header;
+    if (count == 1 && options.padding_size == 0) {
+        // 0号包
+        header.push_back(toc);
+        if (options.self_delimiting) {
+            appendFrameSize(frames[0].length, header);
+        }
+    } else if (count == 2 && cbr && options.padding_size == 0) {
+        // 1号包
+        header.push_back(toc | 0x01);
+        if (options.self_delimiting) {
+            appendFrameSize(frames[0].length, header);
+        }
+    } else if (count == 2 && options.padding_size == 0) {
+        // 2号包
+        header.push_back(toc | 0x02);
+        appendFrameSize(frames[0].length, header);
+        if (options.self_delimiting) {
+            appendFrameSize(frames[1].length, header);
+        }
+    } else {
+        // 3号包
+        header.push_back(toc | 0x03);
+        uint8_t frame_count_byte = static_cast<uint8_t>(count);
+        if (!cbr) {
+            frame_count_byte |= 0x80;
+        }
+        if (options.padding_size > 0) {
+            frame_count_byte |= 0x40;
+        }
+        header.push_back(frame_count_byte);
+        if (options.padding_size > 0) {
+            encodePaddingLength(options.padding_size, header);
+        }
+        if (!cbr) {
+            for (size_t i = 0; i + 1 < count; i++) {
+                appendFrameSize(frames[i].length, header);
+            }
+        }
+        if (options.self_delimiting) {
+            appendFrameSize(frames[count - 1].length, header);
+        }
+    }
+
+    // header 不再变化，iovec 可以指向其内部
+    appendIov(packet.iov, header.data(), header.size());
+    for (size_t i = 0; i < count; i++) {
+        appendIov(packet.iov, frames[i].data, frames[i].length);
+    }
+    uint32_t padding = options.padding_size;
+    while (padding > 0) {
+        size_t chunk = padding < sizeof(kZeroPadding) ? padding : sizeof(kZeroPadding);
+        appendIov(packet.iov, kZeroPadding, chunk);
+        padding -= static_cast<uint32_t>(chunk);
+    }
+    packet.total_size = header.size() + payload_size + options.padding_size;
+    return true;
+}
+
+bool writeOpusPacket(int fd, const OpusPacketBuffer& packet) {
+    std::vector<struct iovec> iov(packet.iov);
+    size_t index = 0;
+    while (index < iov.size()) {
+        size_t batch = iov.size() - index;
+        if (batch > IOV_MAX) {
+            batch = IOV_MAX;
+        }
+        ssize_t n = writev(fd, &iov[index], static_cast<int>(batch));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        // 跳过已完整写入的片段，调整部分写入的片段
+        size_t written = static_cast<size_t>(n);
+        while (index < iov.size() && written >= iov[index].iov_len) {
+            written -= iov[index].iov_len;
+            index++;
+        }
+        if (written > 0) {
+            iov[index].iov_base = static_cast<uint8_t*>(iov[index].iov_base) + written;
+            iov[index].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+OpusRepacketizer::OpusRepacketizer() : toc_(0), samples_(0) {
+}
+
+void OpusRepacketizer::reset() {
+    frames_.clear();
+    samples_ = 0;
+}
+
+bool OpusRepacketizer::addPacket(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info) {
+    if (data == nullptr || length < 1) {
+        return false;
+    }
+    // 只能合并 config 和立体声标志相同的帧
+    if (!frames_.empty() && (toc_ & 0xFC) != (frame_info.toc_byte & 0xFC)) {
+        return false;
+    }
+    uint32_t samples = getFrameSamples(frame_info.frame_size) * frame_info.frame_count;
+    if (frames_.size() + frame_info.frame_sizes.size() > kMaxFrameCount ||
+        samples_ + samples > kMaxPacketSamples) {
+        return false;
+    }
+
+    std::vector<uint32_t> offsets;
+    if (!getFrameOffsets(frame_info, offsets)) {
+        return false;
+    }
+    for (size_t i = 0; i < offsets.size(); i++) {
+        if (offsets[i] + frame_info.frame_sizes[i] > length) {
+            return false;
+        }
+    }
+
+    toc_ = frame_info.toc_byte;
+    for (size_t i = 0; i < offsets.size(); i++) {
+        OpusFrameSpan span;
+        span.data = data + offsets[i];
+        span.length = frame_info.frame_sizes[i];
+        frames_.push_back(span);
+    }
+    samples_ += samples;
+    return true;
+}
+
+void OpusRepacketizer::retainFrames() {
+    size_t total = 0;
+    for (size_t i = 0; i < frames_.size(); i++) {
+        total += frames_[i].length;
+    }
+    // 复制到新缓冲区再交换：已复制过的帧可能就在 storage_ 中
+    std::vector<uint8_t> storage(total);
+    size_t offset = 0;
+    for (size_t i = 0; i < frames_.size(); i++) {
+        OpusFrameSpan& span = frames_[i];
+        if (span.length > 0) {
+            memcpy(&storage[offset], span.data, span.length);
+        }
+        span.data = storage.data() + offset;
+        offset += span.length;
+    }
+    storage_.swap(storage);
+}
+
+bool OpusRepacketizer::buildPacket(const OpusPacketOptions& options, OpusPacketBuffer& packet) const {
+    return buildOpusPacket(toc_, frames_, options, packet);
+}
+
+} // namespace opus_analyzer
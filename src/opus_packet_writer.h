@@ -0,0 +1,124 @@
+/*
+ * Opus Packet Writer
+ * Opus 包写入：帧长度/填充编码与重组包（repacketizer）
+ */
+
+#pragma once
+
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 帧数据片段（指向调用方的缓冲区，不复制）
+struct OpusFrameSpan {
+    const uint8_t* data;          // 帧数据
+    uint32_t length;              // 帧长度（字节）
+};
+
+// 组包选项
+struct OpusPacketOptions {
+    bool self_delimiting;         // 是否输出带分界包（RFC 6716 附录 B）
+    uint32_t padding_size;        // 填充字节数（非 0 时强制使用 3 号包）
+};
+
+// 组包结果：包头由本结构持有，帧数据通过 iovec 指向原缓冲区
+// 注意：iov 指向 header 内部，复制本结构后需重新组包
+struct OpusPacketBuffer {
+    std::vector<uint8_t> header;  // TOC、帧数字节、填充长度、帧长度字段
+    std::vector<struct iovec> iov; // 按顺序输出的片段
+    size_t total_size;            // 包总大小（字节）
+};
+
+/**
+ * 编码帧长度（1-2字节）
+ * @param frame_size 帧长度（0-1275）
+ * @param out 输出缓冲区（至少 2 字节）
+ * @return 写入的字节数，帧长度无效时返回 0
+ */
+size_t encodeFrameSizeEncoding(uint32_t frame_size, uint8_t* out);
+
+/**
+ * 编码填充长度
+ * @param padding_size 填充字节数
+ * @param out 输出：追加填充长度编码
+ * @return 写入的字节数
+ */
+size_t encodePaddingLength(uint32_t padding_size, std::vector<uint8_t>& out);
+
+/**
+ * 由帧片段构造 Opus 包（0-3 号包自动选择）
+ * @param toc TOC 字节（仅使用 config 和 s 位）
+ * @param frames 帧片段
+ * @param options 组包选项
+ * @param packet 输出：包头和 iovec 列表
+ * @return 是否成功
+ */
+bool buildOpusPacket(uint8_t toc, const std::vector<OpusFrameSpan>& frames,
+                     const OpusPacketOptions& options, OpusPacketBuffer& packet);
+
+/**
+ * 将组包结果写入文件描述符（writev）
+ * @param fd 文件描述符
+ * @param packet 组包结果
+ * @return 是否全部写入
+ */
+bool writeOpusPacket(int fd, const OpusPacketBuffer& packet);
+
+/**
+ * 重组包器：收集多个包中配置相同的帧，再输出为一个包
+ * 帧数据不复制，输出前调用方需保证原缓冲区有效，或先调用 retainFrames 复制到内部缓冲区。
+ */
+class OpusRepacketizer {
+public:
+    OpusRepacketizer();
+
+    /**
+     * 清空已收集的帧
+     */
+    void reset();
+
+    /**
+     * 加入一个已解析的包中的所有帧
+     * @param data Opus 包数据（从 TOC 开始）
+     * @param length 数据长度
+     * @param frame_info parseOpusPacket 的解析结果
+     * @return 是否加入成功（配置不同、超过 120 ms 或 48 帧时返回 false）
+     */
+    bool addPacket(const uint8_t* data, size_t length, const OpusFrameInfo& frame_info);
+
+    /**
+     * 把已收集的帧数据复制到内部缓冲区，之后原缓冲区可以归还或复用
+     * 最多 48 帧，每帧不超过 1275 字节，复制量很小。
+     */
+    void retainFrames();
+
+    /**
+     * 已收集的帧数
+     */
+    size_t frameCount() const { return frames_.size(); }
+
+    /**
+     * 已收集帧的总采样数（48 kHz）
+     */
+    uint32_t sampleCount() const { return samples_; }
+
+    /**
+     * 由已收集的帧构造包
+     * @param options 组包选项
+     * @param packet 输出：组包结果
+     * @return 是否成功
+     */
+    bool buildPacket(const OpusPacketOptions& options, OpusPacketBuffer& packet) const;
+
+private:
+    uint8_t toc_;
+    uint32_t samples_;
+    std::vector<OpusFrameSpan> frames_;
+    std::vector<uint8_t> storage_;    // retainFrames 复制的帧数据
+};
+
+} // namespace opus_analyzer
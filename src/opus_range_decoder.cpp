@@ -0,0 +1,165 @@
+/*
+ * Opus Range Decoder
+ * RFC 6716 区间解码器实现（参考 libopus entdec.c）
+ */
+
+#include "opus_range_decoder.h"
+
+namespace opus_analyzer {
+
+namespace {
+
+const int EC_SYM_BITS = 8;
+const int EC_CODE_BITS = 32;
+const uint32_t EC_SYM_MAX = (1U << EC_SYM_BITS) - 1;
+const uint32_t EC_CODE_TOP = 1U << (EC_CODE_BITS - 1);
+const uint32_t EC_CODE_BOT = EC_CODE_TOP >> EC_SYM_BITS;
+const int EC_CODE_EXTRA = (EC_CODE_BITS - 2) % EC_SYM_BITS + 1;
+const int EC_UINT_BITS = 8;
+const int EC_WINDOW_SIZE = 32;
+
+// 整数的有效比特数（x = 0 时为 0）
+int ecIlog(uint32_t x) {
+    int n = 0;
+    while (x != 0) {
+        n++;
+        x >>= 1;
+    }
+    return n;
+}
+
+} // namespace
+
+OpusRangeDecoder::OpusRangeDecoder(const uint8_t* data, size_t length)
+    : buf_(data),
+      storage_(static_cast<uint32_t>(length)),
+      end_offs_(0),
+      end_window_(0),
+      nend_bits_(0),
+      nbits_total_(EC_CODE_BITS + 1 - ((EC_CODE_BITS - EC_CODE_EXTRA) / EC_SYM_BITS) * EC_SYM_BITS),
+      offs_(0),
+      rng_(1U << EC_CODE_EXTRA),
+      val_(0),
+      ext_(0),
+      rem_(0),
+      error_(false) {
+    rem_ = readByte();
+    val_ = rng_ - 1 - (rem_ >> (EC_SYM_BITS - EC_CODE_EXTRA));
+    normalize();
+}
+
+int OpusRangeDecoder::readByte() {
+    return offs_ < storage_ ? buf_[offs_++] : 0;
+}
+
+int OpusRangeDecoder::readByteFromEnd() {
+    return end_offs_ < storage_ ? buf_[storage_ - ++end_offs_] : 0;
+}
+
+void OpusRangeDecoder::normalize() {
+    // 保持 rng 大于 EC_CODE_BOT，每次移入一个字节
+    while (rng_ <= EC_CODE_BOT) {
+        nbits_total_ += EC_SYM_BITS;
+        rng_ <<= EC_SYM_BITS;
+        int sym = rem_;
+        rem_ = readByte();
+        sym = (sym << EC_SYM_BITS | rem_) >> (EC_SYM_BITS - EC_CODE_EXTRA);
+        val_ = ((val_ << EC_SYM_BITS) + (EC_SYM_MAX & ~static_cast<uint32_t>(sym))) & (EC_CODE_TOP - 1);
+    }
+}
+
+uint32_t OpusRangeDecoder::decode(uint32_t ft) {
+    ext_ = rng_ / ft;
+    uint32_t s = val_ / ext_;
+    return ft - (s + 1 < ft ? s + 1 : ft);
+}
+
+void OpusRangeDecoder::update(uint32_t fl, uint32_t fh, uint32_t ft) {
+    uint32_t s = ext_ * (ft - fh);
+    val_ -= s;
+    rng_ = fl > 0 ? ext_ * (fh - fl) : rng_ - s;
+    normalize();
+}
+
+bool OpusRangeDecoder::decodeBitLogp(unsigned logp) {
+    uint32_t r = rng_;
+    uint32_t d = val_;
+    uint32_t s = r >> logp;
+    bool ret = d < s;
+    if (!ret) {
+        val_ = d - s;
+    }
+    rng_ = ret ? s : r - s;
+    normalize();
+    return ret;
+}
+
+int OpusRangeDecoder::decodeIcdf(const uint8_t* icdf, unsigned ftb) {
+    uint32_t s = rng_;
+    uint32_t d = val_;
+    uint32_t r = s >> ftb;
+    uint32_t t;
+    int ret = -1;
+    do {
+        t = s;
+        s = r * icdf[++ret];
+    } while (d < s);
+    val_ = d - s;
+    rng_ = t - s;
+    normalize();
+    return ret;
+}
+
+uint32_t OpusRangeDecoder::decodeUint(uint32_t ft) {
+    if (ft <= 1) {
+        error_ = true;
+        return 0;
+    }
+    ft--;
+    int ftb = ecIlog(ft);
+    if (ftb > EC_UINT_BITS) {
+        // 高位按区间编码，低位为原始比特
+        ftb -= EC_UINT_BITS;
+        uint32_t ft1 = (ft >> ftb) + 1;
+        uint32_t s = decode(ft1);
+        update(s, s + 1, ft1);
+        uint32_t t = (s << ftb) | decodeBits(ftb);
+        if (t <= ft) {
+            return t;
+        }
+        error_ = true;
+        return ft;
+    }
+    ft++;
+    uint32_t s = decode(ft);
+    update(s, s + 1, ft);
+    return s;
+}
+
+uint32_t OpusRangeDecoder::decodeBits(unsigned bits) {
+    uint32_t window = end_window_;
+    int available = nend_bits_;
+    if (available < static_cast<int>(bits)) {
+        do {
+            window |= static_cast<uint32_t>(readByteFromEnd()) << available;
+            available += EC_SYM_BITS;
+        } while (available <= EC_WINDOW_SIZE - EC_SYM_BITS);
+    }
+    uint32_t ret = window & ((1U << bits) - 1U);
+    window >>= bits;
+    available -= bits;
+    end_window_ = window;
+    nend_bits_ = available;
+    nbits_total_ += bits;
+    return ret;
+}
+
+int OpusRangeDecoder::tell() const {
+    return nbits_total_ - ecIlog(rng_);
+}
+
+void OpusRangeDecoder::skipToEnd(int total_bits) {
+    nbits_total_ += total_bits - tell();
+}
+
+} // namespace opus_analyzer
@@ -0,0 +1,94 @@
+/*
+ * Opus Range Decoder
+ * RFC 6716 第 4.1 节区间解码器（仅用于读取帧头部的少量符号）
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace opus_analyzer {
+
+/**
+ * 区间解码器
+ * 实现与 libopus entdec.c 一致，支持按概率解码比特、按 iCDF 表解码符号、
+ * 解码均匀分布整数以及从帧尾读取原始比特。
+ * 只解码帧开头的若干符号，不做完整的 SILK/CELT 解码。
+ */
+class OpusRangeDecoder {
+public:
+    /**
+     * 初始化解码器
+     * @param data 帧数据（不含 TOC 及帧长度字段）
+     * @param length 帧长度（字节）
+     */
+    OpusRangeDecoder(const uint8_t* data, size_t length);
+
+    /**
+     * 解码一个比特，其为 1 的概率为 1/(2^logp)
+     * @param logp 概率的对数
+     * @return 解码得到的比特
+     */
+    bool decodeBitLogp(unsigned logp);
+
+    /**
+     * 按逆累积分布表解码一个符号
+     * @param icdf 逆累积分布表（以 0 结尾）
+     * @param ftb 总频数的对数
+     * @return 符号索引
+     */
+    int decodeIcdf(const uint8_t* icdf, unsigned ftb);
+
+    /**
+     * 解码 [0, ft) 范围内均匀分布的整数
+     * @param ft 取值个数（必须大于 1）
+     * @return 解码得到的整数
+     */
+    uint32_t decodeUint(uint32_t ft);
+
+    /**
+     * 从帧尾读取原始比特
+     * @param bits 比特数（不超过 25）
+     * @return 读取的值
+     */
+    uint32_t decodeBits(unsigned bits);
+
+    /**
+     * 已消耗的比特数（向上取整），等同于 libopus 的 ec_tell()
+     */
+    int tell() const;
+
+    /**
+     * 将已消耗比特数设置到帧末尾（CELT 静音帧的处理方式）
+     * @param total_bits 帧的总比特数
+     */
+    void skipToEnd(int total_bits);
+
+    /**
+     * 是否发生过解码错误
+     */
+    bool hasError() const { return error_; }
+
+private:
+    int readByte();
+    int readByteFromEnd();
+    void normalize();
+    uint32_t decode(uint32_t ft);
+    void update(uint32_t fl, uint32_t fh, uint32_t ft);
+
+    const uint8_t* buf_;
+    uint32_t storage_;
+    uint32_t end_offs_;
+    uint32_t end_window_;
+    int nend_bits_;
+    int nbits_total_;
+    uint32_t offs_;
+    uint32_t rng_;
+    uint32_t val_;
+    uint32_t ext_;
+    int rem_;
+    bool error_;
+};
+
+} // namespace opus_analyzer
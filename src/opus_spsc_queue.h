@@ -0,0 +1,101 @@
+/*
+ * SPSC Queue
+ * 有界单生产者/单消费者无锁环形队列
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace opus_analyzer {
+
+/**
+ * 有界 SPSC 环形队列
+ * 只允许一个线程 push、一个线程 pop。队列元素一般是指针（缓冲区或批次的句柄），
+ * 不在队列中复制数据。队列满/空时阻塞等待：先自旋让出 CPU，长时间等待后短暂休眠。
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @param capacity 容量（向上取整为 2 的幂）
+     */
+    explicit SpscQueue(size_t capacity)
+        : mask_(0), head_(0), tail_(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+
+    /**
+     * 尝试入队（仅生产者线程调用）
+     * @return 队列已满时返回 false
+     */
+    bool tryPush(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        buffer_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 尝试出队（仅消费者线程调用）
+     * @return 队列为空时返回 false
+     */
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 入队，队列满时阻塞
+     */
+    void push(const T& value) {
+        for (unsigned spins = 0; !tryPush(value); spins++) {
+            backoff(spins);
+        }
+    }
+
+    /**
+     * 出队，队列为空时阻塞
+     */
+    T pop() {
+        T value;
+        for (unsigned spins = 0; !tryPop(value); spins++) {
+            backoff(spins);
+        }
+        return value;
+    }
+
+private:
+    static void backoff(unsigned spins) {
+        if (spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::vector<T> buffer_;
+    size_t mask_;
+    // 生产者和消费者的索引放在不同的缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+} // namespace opus_analyzer
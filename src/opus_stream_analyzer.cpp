@@ -0,0 +1,237 @@
+/*
+ * Opus Stream Analyzer
+ * 流统计摘要与定位索引实现
+ */
+
+#include "opus_stream_analyzer.h"
+#include "opus_fingerprint.h"
+#include "opus_packet_stream.h"
+#include "opus_trace.h"
+#include "opus_utils.h"
+#include <string.h>
+
+namespace opus_analyzer {
+
+namespace {
+
+const int kParseBatch = 4096;    // 每个跟踪区间内解析的包数
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool getVarint(const uint8_t* data, size_t length, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= length) {
+            return false;
+        }
+        uint8_t b = data[pos++];
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void putSummary(std::vector<uint8_t>& out, const OpusStreamSummary& s) {
+    putVarint(out, s.packet_count);
+    putVarint(out, s.frame_count);
+    putVarint(out, s.total_bytes);
+    putVarint(out, s.total_samples);
+    putVarint(out, s.end_offset);
+    putVarint(out, s.skipped_bytes);
+    putVarint(out, s.min_packet_size);
+    putVarint(out, s.max_packet_size);
+    putVarint(out, s.stereo_count);
+    for (int i = 0; i < 4; i++) {
+        putVarint(out, s.code_counts[i]);
+    }
+    for (int i = 0; i < 32; i++) {
+        putVarint(out, s.config_counts[i]);
+    }
+}
+
+bool getSummary(const uint8_t* data, size_t length, size_t& pos, OpusStreamSummary& s) {
+    uint64_t* fields[] = {&s.packet_count, &s.frame_count, &s.total_bytes, &s.total_samples,
+                          &s.end_offset, &s.skipped_bytes};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (!getVarint(data, length, pos, *fields[i])) {
+            return false;
+        }
+    }
+    uint64_t v = 0;
+    if (!getVarint(data, length, pos, v)) return false;
+    s.min_packet_size = static_cast<uint32_t>(v);
+    if (!getVarint(data, length, pos, v)) return false;
+    s.max_packet_size = static_cast<uint32_t>(v);
+    if (!getVarint(data, length, pos, s.stereo_count)) return false;
+    for (int i = 0; i < 4; i++) {
+        if (!getVarint(data, length, pos, s.code_counts[i])) return false;
+    }
+    for (int i = 0; i < 32; i++) {
+        if (!getVarint(data, length, pos, s.config_counts[i])) return false;
+    }
+    return true;
+}
+
+// 解析包流中剩余的包，累加到 analysis
+bool analyzeStream(OpusPacketStream& stream, OpusFileAnalysis& analysis, std::vector<uint64_t>* fingerprints,
+                   std::vector<OpusByteRange>* skipped_ranges) {
+    OpusStreamSummary& summary = analysis.summary;
+    uint64_t skipped_base = summary.skipped_bytes;
+    OpusStreamPacket packet;
+    bool more = true;
+    while (more) {
+        OPUS_TRACE_SCOPE("parse");
+        for (int i = 0; i < kParseBatch && (more = stream.next(packet)); i++) {
+            summary.skipped_bytes = skipped_base + stream.skippedBytes();
+
+            // 每隔 OPUS_SEEK_INTERVAL 采样记录定位点，同时保存检查点
+            if (summary.total_samples >= analysis.index.size() * OPUS_SEEK_INTERVAL) {
+                OpusSeekPoint point;
+                point.offset = packet.offset;
+                point.sample = summary.total_samples;
+                point.packet = summary.packet_count;
+                analysis.index.push_back(point);
+                analysis.checkpoint = summary;
+                analysis.checkpoint.end_offset = packet.offset;
+            }
+            accumulatePacket(summary, packet.frame_info, packet.size, packet.offset);
+            if (fingerprints != nullptr) {
+                fingerprints->push_back(fingerprintPacket(packet.data, packet.size, packet.frame_info));
+            }
+        }
+    }
+    summary.skipped_bytes = skipped_base + stream.skippedBytes();
+    if (skipped_ranges != nullptr) {
+        const std::vector<OpusByteRange>& ranges = stream.sync().skippedRanges();
+        skipped_ranges->insert(skipped_ranges->end(), ranges.begin(), ranges.end());
+    }
+    return !stream.hasError();
+}
+
+// 从检查点继续：恢复检查点处的摘要，丢弃检查点之后的定位点，返回继续分析的位置
+uint64_t resumeFromCheckpoint(OpusFileAnalysis& analysis) {
+    analysis.summary = analysis.checkpoint;
+    uint64_t base = analysis.checkpoint.end_offset;
+    while (!analysis.index.empty() && analysis.index.back().offset > base) {
+        analysis.index.pop_back();
+    }
+    return base;
+}
+
+} // namespace
+
+void accumulatePacket(OpusStreamSummary& summary, const OpusFrameInfo& frame_info,
+                      uint32_t packet_size, uint64_t offset) {
+    if (summary.packet_count == 0 || packet_size < summary.min_packet_size) {
+        summary.min_packet_size = packet_size;
+    }
+    if (packet_size > summary.max_packet_size) {
+        summary.max_packet_size = packet_size;
+    }
+    summary.packet_count++;
+    summary.frame_count += frame_info.frame_count;
+    summary.total_bytes += packet_size;
+    summary.total_samples += static_cast<uint64_t>(getFrameSamples(frame_info.frame_size)) * frame_info.frame_count;
+    summary.end_offset = offset + packet_size;
+    if (frame_info.stereo) {
+        summary.stereo_count++;
+    }
+    summary.code_counts[frame_info.frame_count_code & 0x03]++;
+    summary.config_counts[frame_info.config & 0x1F]++;
+}
+
+void resetFileAnalysis(OpusFileAnalysis& analysis) {
+    memset(&analysis.summary, 0, sizeof(analysis.summary));
+    memset(&analysis.checkpoint, 0, sizeof(analysis.checkpoint));
+    analysis.index.clear();
+}
+
+bool analyzeOpusFile(const char* path, OpusFileAnalysis& analysis, std::vector<uint64_t>* fingerprints,
+                     std::vector<OpusByteRange>* skipped_ranges) {
+    uint64_t base = resumeFromCheckpoint(analysis);
+    OpusPacketStream stream;
+    if (!stream.open(path, base)) {
+        return false;
+    }
+    return analyzeStream(stream, analysis, fingerprints, skipped_ranges);
+}
+
+bool analyzeOpusBuffer(const uint8_t* data, size_t length, OpusFileAnalysis& analysis,
+                       std::vector<uint64_t>* fingerprints, std::vector<OpusByteRange>* skipped_ranges) {
+    if (data == nullptr && length > 0) {
+        return false;
+    }
+    uint64_t base = resumeFromCheckpoint(analysis);
+    if (base > length) {
+        return false;
+    }
+    OpusPacketStream stream;
+    stream.attach(data, length, base);
+    return analyzeStream(stream, analysis, fingerprints, skipped_ranges);
+}
+
+void serializeStreamSummary(const OpusStreamSummary& summary, std::vector<uint8_t>& out) {
+    putSummary(out, summary);
+}
+
+bool deserializeStreamSummary(const uint8_t* data, size_t length, OpusStreamSummary& summary, size_t& bytes_read) {
+    size_t pos = 0;
+    memset(&summary, 0, sizeof(summary));
+    if (!getSummary(data, length, pos, summary)) {
+        return false;
+    }
+    bytes_read = pos;
+    return true;
+}
+
+void serializeFileAnalysis(const OpusFileAnalysis& analysis, std::vector<uint8_t>& out) {
+    putSummary(out, analysis.summary);
+    putSummary(out, analysis.checkpoint);
+    putVarint(out, analysis.index.size());
+    OpusSeekPoint prev = {0, 0, 0};
+    for (size_t i = 0; i < analysis.index.size(); i++) {
+        const OpusSeekPoint& point = analysis.index[i];
+        putVarint(out, point.offset - prev.offset);
+        putVarint(out, point.sample - prev.sample);
+        putVarint(out, point.packet - prev.packet);
+        prev = point;
+    }
+}
+
+bool deserializeFileAnalysis(const uint8_t* data, size_t length, OpusFileAnalysis& analysis, size_t& bytes_read) {
+    size_t pos = 0;
+    resetFileAnalysis(analysis);
+    if (!getSummary(data, length, pos, analysis.summary) || !getSummary(data, length, pos, analysis.checkpoint)) {
+        return false;
+    }
+    uint64_t count = 0;
+    if (!getVarint(data, length, pos, count) || count > length) {
+        return false;
+    }
+    OpusSeekPoint point = {0, 0, 0};
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t d_offset = 0;
+        uint64_t d_sample = 0;
+        uint64_t d_packet = 0;
+        if (!getVarint(data, length, pos, d_offset) || !getVarint(data, length, pos, d_sample) ||
+            !getVarint(data, length, pos, d_packet)) {
+            return false;
+        }
+        point.offset += d_offset;
+        point.sample += d_sample;
+        point.packet += d_packet;
+        analysis.index.push_back(point);
+    }
+    bytes_read = pos;
+    return true;
+}
+
+} // namespace opus_analyzer
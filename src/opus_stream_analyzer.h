@@ -0,0 +1,124 @@
+/*
+ * Opus Stream Analyzer
+ * 整个裸流的统计摘要与定位索引
+ */
+
+#pragma once
+
+#include "opus_packet_sync.h"
+#include "opus_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace opus_analyzer {
+
+// 流统计摘要
+struct OpusStreamSummary {
+    uint64_t packet_count;        // 包数
+    uint64_t frame_count;         // 帧数
+    uint64_t total_bytes;         // 所有包的总字节数
+    uint64_t total_samples;       // 总采样数（48 kHz）
+    uint64_t end_offset;          // 最后一个包的结束位置
+    uint64_t skipped_bytes;       // 无法解析而跳过的字节数
+    uint32_t min_packet_size;     // 最小包大小
+    uint32_t max_packet_size;     // 最大包大小
+    uint64_t stereo_count;        // 立体声包数
+    uint64_t code_counts[4];      // 各帧数代码的包数
+    uint64_t config_counts[32];   // 各配置数的包数
+};
+
+// 定位点：每隔固定时长记录一个包的位置
+struct OpusSeekPoint {
+    uint64_t offset;              // 包起始位置
+    uint64_t sample;              // 包之前的累计采样数（48 kHz）
+    uint64_t packet;              // 包序号（从 0 开始）
+};
+
+// 文件分析结果
+struct OpusFileAnalysis {
+    OpusStreamSummary summary;    // 整个文件的摘要
+    OpusStreamSummary checkpoint; // 最后一个定位点处的摘要，追加数据时从这里继续
+    std::vector<OpusSeekPoint> index; // 定位索引
+};
+
+// 定位点间隔（48 kHz 采样数，1 秒）
+const uint64_t OPUS_SEEK_INTERVAL = 48000;
+
+/**
+ * 清空分析结果
+ * @param analysis 分析结果
+ */
+void resetFileAnalysis(OpusFileAnalysis& analysis);
+
+/**
+ * 将一个包计入摘要
+ * @param summary 摘要
+ * @param frame_info parseOpusPacket 的解析结果
+ * @param packet_size 包大小
+ * @param offset 包起始位置
+ */
+void accumulatePacket(OpusStreamSummary& summary, const OpusFrameInfo& frame_info,
+                      uint32_t packet_size, uint64_t offset);
+
+/**
+ * 分析 Opus 裸流文件
+ * 从 analysis.checkpoint 记录的位置继续分析（新分析前先调用 resetFileAnalysis）。
+ * @param path 文件路径
+ * @param analysis 输入/输出：分析结果
+ * @param fingerprints 输出：本次解析的每个包的指纹（可为 nullptr）
+ * @param skipped_ranges 输出：本次解析跳过的字节区间，最多 OPUS_SYNC_MAX_RANGES 个（可为 nullptr）
+ * @return 是否成功
+ */
+bool analyzeOpusFile(const char* path, OpusFileAnalysis& analysis, std::vector<uint64_t>* fingerprints = nullptr,
+                     std::vector<OpusByteRange>* skipped_ranges = nullptr);
+
+/**
+ * 分析内存中的整个 Opus 裸流（例如 mmap 映射的文件）
+ * 与 analyzeOpusFile 相同，从 analysis.checkpoint 记录的位置继续分析。
+ * @param data 流数据
+ * @param length 数据长度
+ * @param analysis 输入/输出：分析结果
+ * @param fingerprints 输出：本次解析的每个包的指纹（可为 nullptr）
+ * @param skipped_ranges 输出：本次解析跳过的字节区间，最多 OPUS_SYNC_MAX_RANGES 个（可为 nullptr）
+ * @return 是否成功
+ */
+bool analyzeOpusBuffer(const uint8_t* data, size_t length, OpusFileAnalysis& analysis,
+                       std::vector<uint64_t>* fingerprints = nullptr,
+                       std::vector<OpusByteRange>* skipped_ranges = nullptr);
+
+/**
+ * 将摘要序列化为紧凑的二进制格式（变长整数）
+ * @param summary 摘要
+ * @param out 输出：追加序列化数据
+ */
+void serializeStreamSummary(const OpusStreamSummary& summary, std::vector<uint8_t>& out);
+
+/**
+ * 反序列化摘要
+ * @param data 序列化数据
+ * @param length 数据长度
+ * @param summary 输出：摘要
+ * @param bytes_read 输出：读取的字节数
+ * @return 是否成功
+ */
+bool deserializeStreamSummary(const uint8_t* data, size_t length, OpusStreamSummary& summary, size_t& bytes_read);
+
+/**
+ * 将分析结果序列化为紧凑的二进制格式（变长整数，索引按差值编码）
+ * @param analysis 分析结果
+ * @param out 输出：追加序列化数据
+ */
+void serializeFileAnalysis(const OpusFileAnalysis& analysis, std::vector<uint8_t>& out);
+
+/**
+ * 反序列化分析结果
+ * @param data 序列化数据
+ * @param length 数据长度
+ * @param analysis 输出：分析结果
+ * @param bytes_read 输出：读取的字节数
+ * @return 是否成功
+ */
+bool deserializeFileAnalysis(const uint8_t* data, size_t length, OpusFileAnalysis& analysis, size_t& bytes_read);
+
+} // namespace opus_analyzer
@@ -0,0 +1,240 @@
+/*
+ * Opus Stream Sampler
+ * 抽样分析实现
+ */
+
+#include "opus_stream_sampler.h"
+#include "opus_packet_sync.h"
+#include "opus_trace.h"
+#include "opus_utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+
+namespace opus_analyzer {
+
+namespace {
+
+const uint64_t kMinWindowSize = 16 * 1024;
+const size_t kWindowOverrun = 4096;    // 窗口后额外读取的字节，让窗口末尾的包能读完整
+const double kZ95 = 1.96;
+
+// 单个窗口的统计
+struct WindowStats {
+    double span;                  // 锁定位置到最后一个包结束的字节数
+    double packets;
+    double bytes;
+    double samples;
+    double configs[32];
+};
+
+// 比率估计 R = Σx / Σy 的 95% 置信区间半宽（含有限总体校正）
+double ratioError(const std::vector<double>& x, const std::vector<double>& y, double ratio, double sampled_fraction) {
+    size_t n = x.size();
+    if (n < 2) {
+        return ratio;
+    }
+    double sum_y = 0;
+    double ss = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = x[i] - ratio * y[i];
+        ss += d * d;
+        sum_y += y[i];
+    }
+    double mean_y = sum_y / n;
+    if (mean_y <= 0) {
+        return ratio;
+    }
+    double fpc = sampled_fraction < 1 ? 1 - sampled_fraction : 0;
+    return kZ95 * sqrt(fpc * ss / (n - 1) / n) / mean_y;
+}
+
+OpusEstimate estimateRatio(const std::vector<double>& x, const std::vector<double>& y, double scale,
+                           double sampled_fraction) {
+    double sum_x = 0;
+    double sum_y = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        sum_x += x[i];
+        sum_y += y[i];
+    }
+    OpusEstimate e;
+    double ratio = sum_y > 0 ? sum_x / sum_y : 0;
+    e.value = ratio * scale;
+    e.error = ratioError(x, y, ratio, sampled_fraction) * scale;
+    return e;
+}
+
+bool readAt(int fd, uint64_t offset, std::vector<uint8_t>& buf) {
+    OPUS_TRACE_SCOPE("read");
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = pread(fd, &buf[done], buf.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    buf.resize(done);
+    return true;
+}
+
+// 解析一个窗口：锁定包边界后，解析起始于窗口内的完整包
+bool sampleWindow(const std::vector<uint8_t>& buf, size_t window_size, uint64_t window_offset,
+                  OpusStreamSummary& sampled, WindowStats& stats) {
+    memset(&stats, 0, sizeof(stats));
+    size_t pos = 0;
+    {
+        OPUS_TRACE_SCOPE("resync");
+        if (!findSyncPoint(buf.data(), buf.size(), 0, window_size, pos)) {
+            return false;
+        }
+    }
+    OPUS_TRACE_SCOPE("parse");
+    size_t lock = pos;
+    OpusPacketSync sync;
+    while (pos < window_size && pos < buf.size()) {
+        OpusFrameInfo frame_info;
+        size_t next = 0;
+        uint32_t packet_size = sync.parse(buf.data(), buf.size(), pos, window_size, window_offset, frame_info, next);
+        if (packet_size == 0) {
+            pos = next;
+            continue;
+        }
+        accumulatePacket(sampled, frame_info, packet_size, window_offset + pos);
+        stats.packets += 1;
+        stats.bytes += packet_size;
+        stats.samples += static_cast<double>(getFrameSamples(frame_info.frame_size)) * frame_info.frame_count;
+        stats.configs[frame_info.config & 0x1F] += 1;
+        pos += packet_size;
+    }
+    sampled.skipped_bytes += sync.skippedBytes();
+    stats.span = static_cast<double>(pos - lock);
+    return stats.packets > 0;
+}
+
+void setExactResult(const OpusStreamSummary& summary, OpusSampleResult& result) {
+    result.sampled = summary;
+    result.exact = true;
+    result.windows = 1;
+    result.bytes_read = result.file_size;
+    result.packets.value = static_cast<double>(summary.packet_count);
+    result.duration.value = summary.total_samples / 48000.0;
+    result.bitrate.value = summary.total_samples > 0 ? summary.total_bytes * 8.0 * 48000 / summary.total_samples : 0;
+    for (int i = 0; i < 32; i++) {
+        result.config_share[i].value = summary.packet_count > 0 ?
+            static_cast<double>(summary.config_counts[i]) / summary.packet_count : 0;
+    }
+}
+
+} // namespace
+
+void getDefaultSampleOptions(OpusSampleOptions& options) {
+    options.fraction = 0.01;
+    options.window_count = 64;
+    options.random = false;
+    options.seed = 1;
+}
+
+bool sampleOpusFile(const char* path, const OpusSampleOptions& options, OpusSampleResult& result) {
+    memset(&result, 0, sizeof(result));
+    int fd;
+    {
+        OPUS_TRACE_SCOPE("open");
+        fd = open(path, O_RDONLY);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+    result.file_size = file_size;
+
+    // 窗口过小时减少窗口数
+    uint64_t window_count = options.window_count > 0 ? options.window_count : 1;
+    uint64_t budget = static_cast<uint64_t>(file_size * (options.fraction > 0 ? options.fraction : 0));
+    uint64_t window_size = budget / window_count;
+    if (window_size < kMinWindowSize) {
+        window_size = kMinWindowSize;
+        window_count = budget / kMinWindowSize > 0 ? budget / kMinWindowSize : 1;
+    }
+
+    // 要读的数据不少于整个文件：完整分析
+    if (options.fraction >= 1 || window_count * (window_size + kWindowOverrun) >= file_size) {
+        close(fd);
+        OpusFileAnalysis analysis;
+        resetFileAnalysis(analysis);
+        if (!analyzeOpusFile(path, analysis)) {
+            return false;
+        }
+        setExactResult(analysis.summary, result);
+        return true;
+    }
+
+    std::mt19937_64 rng(options.seed);
+    uint64_t stratum = file_size / window_count;
+    std::vector<double> spans;
+    std::vector<double> packets;
+    std::vector<double> bytes;
+    std::vector<double> samples;
+    std::vector<std::vector<double> > configs(32);
+    std::vector<uint8_t> buf;
+    bool ok = true;
+
+    for (uint64_t i = 0; i < window_count; i++) {
+        uint64_t start = i * stratum;
+        if (options.random && stratum > window_size) {
+            start += rng() % (stratum - window_size + 1);
+        }
+        buf.resize(window_size + kWindowOverrun);
+        if (!readAt(fd, start, buf)) {
+            ok = false;
+            break;
+        }
+        result.bytes_read += buf.size();
+
+        WindowStats stats;
+        if (!sampleWindow(buf, window_size, start, result.sampled, stats)) {
+            continue;
+        }
+        result.windows++;
+        spans.push_back(stats.span);
+        packets.push_back(stats.packets);
+        bytes.push_back(stats.bytes);
+        samples.push_back(stats.samples);
+        for (int c = 0; c < 32; c++) {
+            configs[c].push_back(stats.configs[c]);
+        }
+    }
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    // 比率估计：按每字节包数、每字节采样数推算全文件，码率和配置占比用各自的比率
+    double f = static_cast<double>(result.bytes_read) / file_size;
+    double size = static_cast<double>(file_size);
+    result.packets = estimateRatio(packets, spans, size, f);
+    result.duration = estimateRatio(samples, spans, size / 48000.0, f);
+    result.bitrate = estimateRatio(bytes, samples, 8.0 * 48000, f);
+    for (int c = 0; c < 32; c++) {
+        result.config_share[c] = estimateRatio(configs[c], packets, 1.0, f);
+    }
+    return true;
+}
+
+} // namespace opus_analyzer
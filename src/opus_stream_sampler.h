@@ -0,0 +1,58 @@
+/*
+ * Opus Stream Sampler
+ * 抽样分析：只读取文件中的若干窗口，估计整个文件的统计量
+ */
+
+#pragma once
+
+#include "opus_stream_analyzer.h"
+#include <stdint.h>
+
+namespace opus_analyzer {
+
+// 抽样参数
+struct OpusSampleOptions {
+    double fraction;              // 读取的文件比例（0-1）
+    uint32_t window_count;        // 窗口数
+    bool random;                  // true：每段内随机取窗口位置；false：取每段开头（等间隔）
+    uint64_t seed;                // 随机种子
+};
+
+// 带误差的估计值
+struct OpusEstimate {
+    double value;                 // 估计值
+    double error;                 // 95% 置信区间半宽
+};
+
+// 抽样结果
+struct OpusSampleResult {
+    OpusStreamSummary sampled;    // 所有窗口内解析到的包的合计
+    uint64_t file_size;           // 文件大小
+    uint64_t bytes_read;          // 实际读取的字节数
+    uint32_t windows;             // 成功锁定包边界的窗口数
+    bool exact;                   // 是否读取了整个文件（估计值即精确值）
+    OpusEstimate packets;         // 估计总包数
+    OpusEstimate duration;        // 估计总时长（秒）
+    OpusEstimate bitrate;         // 估计平均码率（bit/s）
+    OpusEstimate config_share[32]; // 各配置数的包数占比
+};
+
+/**
+ * 默认抽样参数：读取 1%，64 个窗口，等间隔
+ * @param options 输出：抽样参数
+ */
+void getDefaultSampleOptions(OpusSampleOptions& options);
+
+/**
+ * 抽样分析 Opus 裸流文件
+ * 文件被均分为 window_count 段，每段读取一个窗口，先用连续包校验锁定包边界，
+ * 再解析窗口内完整的包，最后按比率估计推算全文件的总量，并给出 95% 置信区间。
+ * 需要读取的数据不少于整个文件时，退化为完整分析。
+ * @param path 文件路径
+ * @param options 抽样参数
+ * @param result 输出：抽样结果
+ * @return 是否成功
+ */
+bool sampleOpusFile(const char* path, const OpusSampleOptions& options, OpusSampleResult& result);
+
+} // namespace opus_analyzer
@@ -0,0 +1,182 @@
+/*
+ * Opus Trace
+ * 耗时跟踪实现（仅在 OPUS_ANALYZER_TRACE 打开时编译）
+ */
+
+#include "opus_trace.h"
+
+#if OPUS_ANALYZER_TRACE
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace opus_analyzer {
+
+namespace {
+
+const size_t kBufferEvents = 32 * 1024;   // 每个线程最多记录的区间数
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// 单个线程的缓冲区：只有所属线程写入，count 以 release 发布，导出时以 acquire 读取
+struct TraceBuffer {
+    uint32_t tid;
+    std::atomic<const char*> thread_name;
+    std::atomic<size_t> count;
+    std::atomic<uint64_t> dropped;
+    TraceEvent events[kBufferEvents];
+};
+
+// 所有线程的缓冲区，直到进程结束时导出。线程退出时缓冲区进入空闲列表，由之后创建的线程接着写入
+// （已记录的区间保留，导出时与新线程显示在同一轨道上），缓冲区个数不超过同时存在的线程数
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<TraceBuffer*> buffers;
+    std::vector<TraceBuffer*> free_buffers;
+    std::chrono::steady_clock::time_point epoch;
+
+    TraceRegistry() : epoch(std::chrono::steady_clock::now()) {}
+};
+
+TraceRegistry& getRegistry() {
+    static TraceRegistry* registry = new TraceRegistry();
+    return *registry;
+}
+
+thread_local TraceBuffer* t_buffer = nullptr;
+
+// 线程退出时把缓冲区还给注册表
+struct TraceBufferOwner {
+    TraceBuffer* buffer;
+
+    TraceBufferOwner() : buffer(nullptr) {}
+    ~TraceBufferOwner() {
+        if (buffer == nullptr) {
+            return;
+        }
+        t_buffer = nullptr;
+        TraceRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.free_buffers.push_back(buffer);
+    }
+};
+
+thread_local TraceBufferOwner t_owner;
+
+TraceBuffer* getThreadBuffer() {
+    if (t_buffer == nullptr) {
+        TraceRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        TraceBuffer* buffer;
+        if (!registry.free_buffers.empty()) {
+            buffer = registry.free_buffers.back();
+            registry.free_buffers.pop_back();
+        } else {
+            buffer = new TraceBuffer();
+            buffer->thread_name.store(nullptr);
+            buffer->count.store(0);
+            buffer->dropped.store(0);
+            buffer->tid = static_cast<uint32_t>(registry.buffers.size() + 1);
+            registry.buffers.push_back(buffer);
+        }
+        t_owner.buffer = buffer;
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - getRegistry().epoch).count());
+}
+
+// 名称都是代码中的常量，只需转义引号和反斜杠
+void writeName(FILE* fp, const char* name) {
+    fputc('"', fp);
+    for (const char* p = name; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', fp);
+        }
+        fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+} // namespace
+
+OpusTraceScope::OpusTraceScope(const char* name) : name_(name), start_ns_(nowNs()) {
+}
+
+OpusTraceScope::~OpusTraceScope() {
+    uint64_t end_ns = nowNs();
+    TraceBuffer* buffer = getThreadBuffer();
+    size_t n = buffer->count.load(std::memory_order_relaxed);
+    if (n >= kBufferEvents) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = buffer->events[n];
+    event.name = name_;
+    event.start_ns = start_ns_;
+    event.duration_ns = end_ns - start_ns_;
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void opusTraceSetThreadName(const char* name) {
+    getThreadBuffer()->thread_name.store(name, std::memory_order_release);
+}
+
+bool opusTraceExport(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (fp == nullptr) {
+        return false;
+    }
+    std::vector<TraceBuffer*> buffers;
+    {
+        TraceRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffers = registry.buffers;
+    }
+
+    // "X" 为完整区间，"M" 为线程名称；时间单位为微秒
+    fprintf(fp, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        const TraceBuffer* buffer = buffers[i];
+        const char* thread_name = buffer->thread_name.load(std::memory_order_acquire);
+        if (thread_name != nullptr) {
+            fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",\n", buffer->tid);
+            writeName(fp, thread_name);
+            fprintf(fp, "}}");
+            first = false;
+        }
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t j = 0; j < count; j++) {
+            const TraceEvent& event = buffer->events[j];
+            fprintf(fp, "%s{\"name\":", first ? "" : ",\n");
+            writeName(fp, event.name);
+            fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid,
+                    event.start_ns / 1000.0, event.duration_ns / 1000.0);
+            first = false;
+        }
+        uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            fprintf(stderr, "警告: 线程 %u 的跟踪缓冲区已满，丢弃了 %llu 个区间\n", buffer->tid,
+                    static_cast<unsigned long long>(dropped));
+        }
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(fp) == 0;
+}
+
+} // namespace opus_analyzer
+
+#endif
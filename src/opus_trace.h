@@ -0,0 +1,70 @@
+/*
+ * Opus Trace
+ * 可选的耗时跟踪：记录各阶段的区间，导出为 Chrome trace JSON（chrome://tracing、Perfetto）
+ *
+ * 编译时定义 OPUS_ANALYZER_TRACE=1（CMake 选项 -DOPUS_ANALYZER_TRACE=ON）才会记录，
+ * 否则下面的宏全部展开为空语句，不产生任何代码。
+ */
+
+#pragma once
+
+#ifndef OPUS_ANALYZER_TRACE
+#define OPUS_ANALYZER_TRACE 0
+#endif
+
+#if OPUS_ANALYZER_TRACE
+
+#include <stdint.h>
+
+namespace opus_analyzer {
+
+/**
+ * 作用域区间：构造时记录开始时间，析构时写入当前线程的缓冲区
+ * 每个线程有自己的定长缓冲区，写入不加锁；缓冲区满后丢弃新的区间并计数。
+ * 线程退出后缓冲区由之后创建的线程复用，频繁创建线程时内存不会随线程数增长。
+ */
+class OpusTraceScope {
+public:
+    /**
+     * @param name 区间名称（必须是字符串常量，只保存指针）
+     */
+    explicit OpusTraceScope(const char* name);
+    ~OpusTraceScope();
+
+private:
+    OpusTraceScope(const OpusTraceScope&);
+    OpusTraceScope& operator=(const OpusTraceScope&);
+
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+/**
+ * 设置当前线程在跟踪结果中显示的名称
+ * @param name 线程名称（必须是字符串常量）
+ */
+void opusTraceSetThreadName(const char* name);
+
+/**
+ * 将所有线程已记录的区间导出为 Chrome trace JSON
+ * @param path 输出文件路径
+ * @return 是否成功
+ */
+bool opusTraceExport(const char* path);
+
+} // namespace opus_analyzer
+
+#define OPUS_TRACE_CONCAT_IMPL(a, b) a##b
+#define OPUS_TRACE_CONCAT(a, b) OPUS_TRACE_CONCAT_IMPL(a, b)
+#define OPUS_TRACE_SCOPE(name) \
+    ::opus_analyzer::OpusTraceScope OPUS_TRACE_CONCAT(opus_trace_scope_, __LINE__)(name)
+#define OPUS_TRACE_THREAD(name) ::opus_analyzer::opusTraceSetThreadName(name)
+#define OPUS_TRACE_EXPORT(path) ::opus_analyzer::opusTraceExport(path)
+
+#else
+
+#define OPUS_TRACE_SCOPE(name) do {} while (0)
+#define OPUS_TRACE_THREAD(name) do {} while (0)
+#define OPUS_TRACE_EXPORT(path) (static_cast<void>(path), false)
+
+#endif
@@ -117,6 +117,18 @@ bool getConfigInfo(uint8_t config, OpusMode& mode, OpusBandwidth& bandwidth, Opu
     return true;
 }
 
+uint32_t getFrameSamples(OpusFrameSize frame_size) {
+    switch (frame_size) {
+        case OpusFrameSize::FRAME_2_5_MS: return 120;
+        case OpusFrameSize::FRAME_5_MS: return 240;
+        case OpusFrameSize::FRAME_10_MS: return 480;
+        case OpusFrameSize::FRAME_20_MS: return 960;
+        case OpusFrameSize::FRAME_40_MS: return 1920;
+        case OpusFrameSize::FRAME_60_MS: return 2880;
+        default: return 0;
+    }
+}
+
 bool parseFrameSizeEncoding(const uint8_t* data, size_t length, uint32_t& frame_size, size_t& bytes_read) {
     if (data == nullptr || length < 1) {
         return false;
@@ -183,6 +195,17 @@ bool parsePaddingLength(const uint8_t* data, size_t length, uint32_t& padding_si
     return true;
 }
 
+uint32_t getPacketSize(const OpusFrameInfo& frame_info) {
+    if (frame_info.total_size > 0) {
+        return frame_info.total_size;
+    }
+    uint32_t size = frame_info.data_offset + frame_info.padding_size;
+    for (size_t i = 0; i < frame_info.frame_sizes.size(); i++) {
+        size += frame_info.frame_sizes[i];
+    }
+    return size;
+}
+
 bool findNextPacket(const uint8_t* data, size_t length, size_t current_offset, size_t& next_offset) {
     if (data == nullptr || length == 0 || current_offset >= length) {
         return false;
@@ -22,6 +22,13 @@ namespace opus_analyzer {
  */
 bool getConfigInfo(uint8_t config, OpusMode& mode, OpusBandwidth& bandwidth, OpusFrameSize& frame_size);
 
+/**
+ * 获取帧长度对应的采样数（48 kHz）
+ * @param frame_size 帧长度
+ * @return 采样数，无效时返回 0
+ */
+uint32_t getFrameSamples(OpusFrameSize frame_size);
+
 /**
  * 解析帧长度编码（1-2字节）
  * @param data 数据指针
@@ -42,6 +49,14 @@ bool parseFrameSizeEncoding(const uint8_t* data, size_t length, uint32_t& frame_
  */
 bool parsePaddingLength(const uint8_t* data, size_t length, uint32_t& padding_size, size_t& bytes_read);
 
+/**
+ * 获取包的实际大小
+ * total_size 未知时（3 号 VBR 包）按数据偏移、各帧长度和填充字节计算
+ * @param frame_info parseOpusPacket 的解析结果
+ * @return 包大小（字节）
+ */
+uint32_t getPacketSize(const OpusFrameInfo& frame_info);
+
 /**
  * 查找下一个 Opus 包的起始位置
  * 注意：Opus 裸流没有明确的包边界，这个函数尝试通过解析包结构来找到下一个包的起始位置